@@ -0,0 +1,80 @@
+#pragma once
+
+#include<cstddef>
+#include<limits>
+#include<new>
+#include<numeric>
+
+#include "vector.hpp"
+
+// Allocator whose blocks start on an Alignment boundary and span a whole
+// number of Alignment-sized blocks. Through allocate_at_least, a vector
+// using it gets the padding as capacity, so data() and
+// capacity() * sizeof(Value) both suit O_DIRECT transfers.
+
+template<class Pointer>
+struct allocation_result {
+	Pointer ptr;
+	std::size_t count;
+};
+
+template<class Value, std::size_t Alignment = 4096>
+class aligned_allocator {
+	static_assert((Alignment & (Alignment - 1)) == 0, "aligned_allocator : Alignment must be a power of 2");
+	static_assert(Alignment >= alignof(Value), "aligned_allocator : Alignment must be at least alignof(Value)");
+
+public:
+
+	using value_type = Value;
+
+	template<class Other>
+	struct rebind {
+		using other = aligned_allocator<Other, Alignment>;
+	};
+
+	static constexpr std::size_t alignment = Alignment;
+
+	// Elements in the smallest whole number of Alignment-sized blocks.
+	static constexpr std::size_t granularity = Alignment / std::gcd(Alignment, sizeof(Value));
+
+	aligned_allocator() noexcept = default;
+
+	template<class Other>
+	aligned_allocator(const aligned_allocator<Other, Alignment>&) noexcept {}
+
+	auto allocate(std::size_t n) -> Value* {
+		return allocate_at_least(n).ptr;
+	}
+
+	// Rounds n up so that the block ends on an Alignment boundary.
+	auto allocate_at_least(std::size_t n) -> allocation_result<Value*> {
+		if(n > (std::numeric_limits<std::size_t>::max() - granularity) / sizeof(Value))
+			throw std::bad_array_new_length{};
+		auto count = allocation_size(n);
+		auto p = ::operator new(count * sizeof(Value), std::align_val_t{Alignment});
+		return {static_cast<Value*>(p), count};
+	}
+
+	// The count allocate_at_least(n) gives.
+	auto allocation_size(std::size_t n) const noexcept -> std::size_t {
+		return (n + granularity - 1) / granularity * granularity;
+	}
+
+	auto deallocate(Value* p, std::size_t) noexcept -> void {
+		::operator delete(p, std::align_val_t{Alignment});
+	}
+};
+
+template<class Value, class Other, std::size_t Alignment>
+auto operator==(const aligned_allocator<Value, Alignment>&, const aligned_allocator<Other, Alignment>&) noexcept -> bool {
+	return true;
+}
+
+template<class Value, class Other, std::size_t Alignment>
+auto operator!=(const aligned_allocator<Value, Alignment>&, const aligned_allocator<Other, Alignment>&) noexcept -> bool {
+	return false;
+}
+
+// Vector for O_DIRECT reads and writes on 4 KiB blocks.
+template<class Value>
+using direct_io_vector = vector<Value, aligned_allocator<Value, 4096>>;
@@ -0,0 +1,623 @@
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <Catch2/catch.hpp>
+
+#include "bench_report.hpp"
+#include "incremental_vector.hpp"
+#include "latency_histogram.hpp"
+#include "perf_counters.hpp"
+#include "vector.hpp"
+#include "vector_arena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// allocation counting
+
+namespace {
+    std::atomic<std::size_t> allocation_count{0};
+    std::atomic<std::size_t> allocation_bytes{0};
+}
+
+// Every replaceable form of new goes through malloc or aligned_alloc, and
+// every form of delete through free, so that the pairs match whichever ones
+// the library calls. The array and nothrow forms of the standard library
+// forward to these. GCC still flags free() on the result of operator new
+// once both are inlined into a call site, hence the pragma.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+auto operator new(std::size_t size) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if(auto allocated = std::malloc(size == 0 ? 1 : size))
+        return allocated;
+    throw std::bad_alloc{};
+}
+
+auto operator new(std::size_t size, const std::nothrow_t&) noexcept -> void* {
+    try {
+        return operator new(size);
+    }
+    catch(const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+auto operator delete(void* allocated) noexcept -> void {
+    std::free(allocated);
+}
+
+auto operator delete(void* allocated, std::size_t) noexcept -> void {
+    std::free(allocated);
+}
+
+auto operator delete(void* allocated, const std::nothrow_t&) noexcept -> void {
+    std::free(allocated);
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    auto align = static_cast<std::size_t>(alignment);
+    if(auto allocated = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return allocated;
+    throw std::bad_alloc{};
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* {
+    try {
+        return operator new(size, alignment);
+    }
+    catch(const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+auto operator delete(void* allocated, std::align_val_t) noexcept -> void {
+    std::free(allocated);
+}
+
+auto operator delete(void* allocated, std::size_t, std::align_val_t) noexcept -> void {
+    std::free(allocated);
+}
+
+auto operator delete(void* allocated, std::align_val_t, const std::nothrow_t&) noexcept -> void {
+    std::free(allocated);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// element types
+
+// Trivially copyable, Size bytes.
+template<std::size_t Size>
+struct blob {
+    std::array<unsigned char, Size> bytes;
+};
+
+// Non-trivial and only movable by a potentially throwing constructor, so
+// std::vector copies it when it grows.
+struct throwing_move {
+    std::string text;
+
+    throwing_move() = default;
+
+    explicit
+    throwing_move(std::string with_text)
+        : text{std::move(with_text)}
+    {}
+
+    throwing_move(const throwing_move&) = default;
+
+    throwing_move(throwing_move&& from) noexcept(false)
+        : text{std::move(from.text)}
+    {}
+
+    auto operator=(const throwing_move&) -> throwing_move& = default;
+
+    auto operator=(throwing_move&& from) noexcept(false) -> throwing_move& {
+        text = std::move(from.text);
+        return *this;
+    }
+};
+
+struct alignas(64) over_aligned {
+    int value;
+};
+
+template<class Value>
+struct element;
+
+template<>
+struct element<int> {
+    static auto name() -> std::string { return "int"; }
+    static auto make(std::size_t seed) -> int { return static_cast<int>(seed); }
+    static auto checksum(int value) -> std::size_t { return static_cast<std::size_t>(value); }
+};
+
+template<std::size_t Size>
+struct element<blob<Size>> {
+    static auto name() -> std::string { return "blob<" + std::to_string(Size) + ">"; }
+
+    static auto make(std::size_t seed) -> blob<Size> {
+        auto value = blob<Size>{};
+        value.bytes[0] = static_cast<unsigned char>(seed);
+        return value;
+    }
+
+    static auto checksum(const blob<Size>& value) -> std::size_t { return value.bytes[0]; }
+};
+
+// Long enough to live outside the small string buffer.
+inline auto make_text(std::size_t seed) -> std::string {
+    auto text = std::to_string(seed);
+    return std::string(32 - text.size(), '0') + text;
+}
+
+template<>
+struct element<std::string> {
+    static auto name() -> std::string { return "string"; }
+    static auto make(std::size_t seed) -> std::string { return make_text(seed); }
+    static auto checksum(const std::string& value) -> std::size_t { return value.back(); }
+};
+
+template<>
+struct element<throwing_move> {
+    static auto name() -> std::string { return "throwing_move"; }
+    static auto make(std::size_t seed) -> throwing_move { return throwing_move{make_text(seed)}; }
+    static auto checksum(const throwing_move& value) -> std::size_t { return value.text.back(); }
+};
+
+template<>
+struct element<over_aligned> {
+    static auto name() -> std::string { return "over_aligned<64>"; }
+    static auto make(std::size_t seed) -> over_aligned { return {static_cast<int>(seed)}; }
+    static auto checksum(const over_aligned& value) -> std::size_t { return static_cast<std::size_t>(value.value); }
+};
+
+template<class Value>
+auto make_value(std::size_t seed) -> Value {
+    return element<Value>::make(seed);
+}
+
+template<class Value>
+auto checksum(const Value& value) -> std::size_t {
+    return element<Value>::checksum(value);
+}
+
+template<class Value>
+auto element_name() -> std::string {
+    return element<Value>::name();
+}
+
+// cases
+
+struct bench_id {
+    std::string container;
+    std::string operation;
+    std::string element_type;
+    std::size_t n;
+    // Operations one run of the case does, e.g. 1 for a reserve and n for
+    // n push_backs : the per operation results are divided by it.
+    std::size_t operations;
+
+    auto name() const -> std::string {
+        return container + " " + operation + " " + element_type + " x " + std::to_string(n);
+    }
+};
+
+struct allocation_counts {
+    std::size_t allocations;
+    std::size_t bytes;
+};
+
+struct case_record {
+    bench_id id;
+    allocation_counts allocations;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+auto case_records() -> std::map<std::string, case_record>& {
+    static auto records = std::map<std::string, case_record>{};
+    return records;
+}
+
+// Set by `--perf-counters`.
+auto perf_counters_enabled = false;
+
+constexpr auto perf_runs = 64;
+
+// Hardware counters per operation of the case, averaged over perf_runs
+// runs, setup() excluded.
+template<class Setup, class Operation>
+auto count_events(const bench_id& id, Setup setup, Operation operation) -> std::vector<std::pair<std::string, double>> {
+    static auto counters = perf_counters{};
+    if(!perf_counters_enabled || !counters.available())
+        return {};
+
+    counters.reset();
+    for(auto run = 0; run < perf_runs; ++run) {
+        auto state = setup();
+        counters.start();
+        operation(state);
+        counters.stop();
+    }
+    auto values = counters.read();
+    auto ops = static_cast<double>(perf_runs) * static_cast<double>(std::max<std::size_t>(id.operations, 1));
+
+    auto result = std::vector<std::pair<std::string, double>>{};
+    std::cerr << id.name() << " per op :";
+    for(auto i = std::size_t{0}; i < perf_counters::count; ++i) {
+        if(!counters.available(i))
+            continue;
+        result.emplace_back(perf_counters::names[i], values[i] / ops);
+        std::cerr << " " << perf_counters::names[i] << " " << values[i] / ops;
+    }
+    std::cerr << "\n";
+    return result;
+}
+
+// Runs operation() once with allocation counting, then benchmarks it.
+template<class Operation>
+auto bench_case(const bench_id& id, Operation operation) -> void {
+    bench_case(id, [] { return 0; }, [&](int) { return operation(); });
+}
+
+// Same, for operations that consume state made by setup(), which is not measured.
+template<class Setup, class Operation>
+auto bench_case(const bench_id& id, Setup setup, Operation operation) -> void {
+    auto state = setup();
+    auto allocations = allocation_count.load();
+    auto bytes = allocation_bytes.load();
+    operation(state);
+    auto counts = allocation_counts{allocation_count.load() - allocations, allocation_bytes.load() - bytes};
+    case_records()[id.name()] = {id, counts, count_events(id, setup, operation)};
+
+    BENCHMARK_ADVANCED(id.name())(Catch::Benchmark::Chronometer meter) {
+        auto states = std::vector<decltype(setup())>{};
+        states.reserve(meter.runs());
+        for(auto run = 0; run < meter.runs(); ++run)
+            states.push_back(setup());
+        meter.measure([&](int run) {
+            return operation(states[run]);
+        });
+    };
+}
+
+template<class Container>
+auto make_filled(std::size_t count) -> Container {
+    auto container = Container{};
+    for(auto i = std::size_t{0}; i < count; ++i)
+        container.push_back(make_value<typename Container::value_type>(i));
+    return container;
+}
+
+template<class Container>
+struct type_tag {
+    using type = Container;
+};
+
+constexpr std::size_t counts[] = {16, 1024, 65536};
+
+// Runs body once for vector and once for the std::vector baseline, on
+// count elements with operations operations per run.
+template<class Value, class Body>
+auto for_each_container(const std::string& operation, std::size_t count, std::size_t operations, Body body) -> void {
+    body(type_tag<vector<Value>>{}, bench_id{"vector", operation, element_name<Value>(), count, operations});
+    body(type_tag<std::vector<Value>>{}, bench_id{"std::vector", operation, element_name<Value>(), count, operations});
+}
+
+// trivially copyable small and large, nothrow-movable non-trivial,
+// throwing move, over-aligned
+#define ELEMENT_TYPES int, blob<256>, std::string, throwing_move, over_aligned
+
+TEMPLATE_TEST_CASE("push_back", "[push_back]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("push_back", count, count, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            bench_case(id, [&] {
+                return make_filled<Container>(count).size();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("reserve", "[reserve]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("reserve", count, 1, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            auto filled = make_filled<Container>(count);
+            bench_case(id, [&] { return filled; }, [&](Container& container) {
+                container.reserve(2 * count);
+                return container.capacity();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("resize", "[resize]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("resize", count, count, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            bench_case(id, [&] {
+                auto container = Container{};
+                container.resize(count);
+                return container.size();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("insert/erase", "[insert][erase]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("insert/erase middle", count, 2, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            auto container = make_filled<Container>(count);
+            container.reserve(count + 1);
+            auto value = make_value<TestType>(count);
+            bench_case(id, [&] {
+                container.insert(container.begin() + count / 2, value);
+                container.erase(container.begin() + count / 2);
+                return container.size();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("copy", "[copy]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("copy", count, count, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            auto filled = make_filled<Container>(count);
+            bench_case(id, [&] {
+                auto copy = filled;
+                return copy.size();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("move", "[move]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("move", count, 1, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            // Moves the elements back and forth between two slots, so that
+            // what each run destroys is the empty container left by the
+            // previous move, and no buffer is freed inside the measure.
+            auto slots = std::array<std::optional<Container>, 2>{make_filled<Container>(count), std::nullopt};
+            auto from = std::size_t{0};
+            bench_case(id, [&] {
+                auto& source = *slots[from];
+                from ^= 1;
+                slots[from].emplace(std::move(source));
+                return slots[from]->size();
+            });
+        });
+}
+
+TEMPLATE_TEST_CASE("iteration", "[iteration]", ELEMENT_TYPES) {
+    for(auto count : counts)
+        for_each_container<TestType>("iteration", count, count, [&](auto tag, const bench_id& id) {
+            using Container = typename decltype(tag)::type;
+            auto filled = make_filled<Container>(count);
+            bench_case(id, [&] {
+                auto sum = std::size_t{0};
+                for(auto& value : filled)
+                    sum += checksum(value);
+                return sum;
+            });
+        });
+}
+
+// Many vectors of 0 to 15 ints, built and dropped together.
+TEST_CASE("small vectors", "[small vectors]") {
+    constexpr std::size_t vector_count = 4096;
+    auto fill = [](auto& vectors) {
+        auto sum = std::size_t{0};
+        for(auto& v : vectors) {
+            for(auto i = std::size_t{0}; i < sum % 16; ++i)
+                v.push_back(static_cast<int>(i));
+            sum += v.size() + 1;
+        }
+        return sum;
+    };
+
+    bench_case({"vector", "small vectors", "int", vector_count, vector_count}, [&] {
+        auto vectors = std::vector<vector<int>>(vector_count);
+        return fill(vectors);
+    });
+    bench_case({"arena_vector", "small vectors", "int", vector_count, vector_count}, [&] {
+        auto arena = vector_arena{};
+        auto vectors = std::vector<arena_vector<int>>(vector_count, arena_vector<int>{arena});
+        return fill(vectors);
+    });
+}
+
+// json reporter, selected with `-r json`
+
+class json_reporter : public Catch::StreamingReporterBase<json_reporter> {
+public:
+
+    using StreamingReporterBase::StreamingReporterBase;
+
+    static auto getDescription() -> std::string {
+        return "Writes benchmark results as JSON, one case per line";
+    }
+
+    auto assertionStarting(const Catch::AssertionInfo&) -> void override {}
+
+    auto assertionEnded(const Catch::AssertionStats&) -> bool override {
+        return true;
+    }
+
+    auto benchmarkEnded(const Catch::BenchmarkStats<>& stats) -> void override {
+        auto& record = case_records().at(stats.info.name);
+        auto operations = static_cast<double>(std::max<std::size_t>(record.id.operations, 1));
+        results_.push_back({
+            stats.info.name,
+            record.id.container,
+            record.id.operation,
+            record.id.element_type,
+            record.id.n,
+            stats.mean.point.count() / operations,
+            static_cast<double>(record.allocations.allocations) / operations,
+            static_cast<double>(record.allocations.bytes) / operations,
+            record.counters,
+        });
+    }
+
+    auto testRunEnded(const Catch::TestRunStats& stats) -> void override {
+        write_bench_results(stream, results_);
+        StreamingReporterBase::testRunEnded(stats);
+    }
+
+private:
+
+    std::vector<bench_result> results_;
+};
+
+CATCH_REGISTER_REPORTER("json", json_reporter)
+
+// `bench --compare baseline.json candidate.json [threshold_percent]`
+auto compare(int argc, char* argv[]) -> int {
+    if(argc < 4) {
+        std::cerr << "usage: " << argv[0] << " --compare baseline.json candidate.json [threshold_percent]\n";
+        return 2;
+    }
+    auto baseline_file = std::ifstream{argv[2]};
+    auto candidate_file = std::ifstream{argv[3]};
+    if(!baseline_file || !candidate_file) {
+        std::cerr << "cannot open result files\n";
+        return 2;
+    }
+    auto threshold = argc > 4 ? std::strtod(argv[4], nullptr) / 100 : 0.1;
+
+    auto regressions = compare_bench_results(
+        read_bench_results(baseline_file),
+        read_bench_results(candidate_file),
+        threshold);
+    for(auto& regression : regressions)
+        std::cout << regression.name << ": " << regression.metric << " "
+            << regression.baseline << " -> " << regression.candidate << "\n";
+    return regressions.empty() ? 0 : 1;
+}
+
+// per-operation latency
+
+// Timestamps from the TSC where there is one, from clock_gettime otherwise.
+struct tick_clock {
+    static auto now() noexcept -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();
+        auto ticks = __rdtsc();
+        _mm_lfence();
+        return ticks;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static auto ns_per_tick() -> double {
+        static auto calibrated = [] {
+            auto start = std::chrono::steady_clock::now();
+            auto start_ticks = now();
+            while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds{20})
+                ;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto elapsed_ticks = now() - start_ticks;
+            return std::chrono::duration<double, std::nano>{elapsed}.count() / elapsed_ticks;
+        }();
+        return calibrated;
+    }
+};
+
+template<class Container>
+auto append_latencies(std::size_t count, std::size_t repetitions) -> latency_histogram<> {
+    auto histogram = latency_histogram<>{};
+    auto ns_per_tick = tick_clock::ns_per_tick();
+    for(auto repetition = std::size_t{0}; repetition < repetitions; ++repetition) {
+        auto container = Container{};
+        for(auto i = std::size_t{0}; i < count; ++i) {
+            auto value = make_value<typename Container::value_type>(i);
+            auto start = tick_clock::now();
+            container.push_back(value);
+            auto stop = tick_clock::now();
+            histogram.record(static_cast<std::uint64_t>((stop - start) * ns_per_tick));
+        }
+    }
+    return histogram;
+}
+
+template<class Value>
+auto print_latencies(std::size_t count) -> void {
+    constexpr auto total_operations = std::size_t{4'000'000};
+    auto repetitions = count < total_operations ? total_operations / count : 1;
+    auto print = [&](const std::string& container, const latency_histogram<>& histogram) {
+        std::cout << std::left << std::setw(12) << container
+            << std::setw(10) << element_name<Value>()
+            << std::right << std::setw(10) << count
+            << std::setw(10) << histogram.percentile(0.5)
+            << std::setw(10) << histogram.percentile(0.99)
+            << std::setw(10) << histogram.percentile(0.999)
+            << std::setw(12) << histogram.max() << "\n";
+    };
+    print("vector", append_latencies<vector<Value>>(count, repetitions));
+    print("std::vector", append_latencies<std::vector<Value>>(count, repetitions));
+    print("incremental", append_latencies<incremental_vector<Value>>(count, repetitions));
+}
+
+// `bench --latency` : push_back latency percentiles in ns, timer overhead included
+auto latency() -> int {
+    auto overhead = latency_histogram<>{};
+    for(auto i = 0; i < 1'000'000; ++i) {
+        auto start = tick_clock::now();
+        auto stop = tick_clock::now();
+        overhead.record(static_cast<std::uint64_t>((stop - start) * tick_clock::ns_per_tick()));
+    }
+    std::cout << "timer overhead p50 " << overhead.percentile(0.5) << " ns\n\n"
+        << std::left << std::setw(12) << "container" << std::setw(10) << "element"
+        << std::right << std::setw(10) << "n" << std::setw(10) << "p50"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << "\n";
+    for(auto count : {std::size_t{1'000}, std::size_t{100'000}, std::size_t{4'000'000}}) {
+        print_latencies<int>(count);
+        print_latencies<blob<32>>(count);
+        print_latencies<blob<256>>(count);
+    }
+    return 0;
+}
+
+auto main(int argc, char* argv[]) -> int {
+    if(argc > 1 && std::string{argv[1]} == "--compare")
+        return compare(argc, argv);
+    if(argc > 1 && std::string{argv[1]} == "--latency")
+        return latency();
+
+    auto catch_arguments = std::vector<char*>{};
+    for(auto i = 0; i < argc; ++i) {
+        if(std::string{argv[i]} == "--perf-counters")
+            perf_counters_enabled = true;
+        else
+            catch_arguments.push_back(argv[i]);
+    }
+    if(perf_counters_enabled && !perf_counters{}.available())
+        std::cerr << "perf_event_open unavailable, see /proc/sys/kernel/perf_event_paranoid\n";
+    return Catch::Session().run(static_cast<int>(catch_arguments.size()), catch_arguments.data());
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include<cstddef>
+#include<cstdlib>
+#include<istream>
+#include<ostream>
+#include<string>
+#include<utility>
+#include<vector>
+
+// Benchmark results as written by the bench executable's json reporter.
+// One case per line, so read_bench_results only has to understand its own
+// output and not arbitrary JSON.
+
+struct bench_result {
+	std::string name;
+	std::string container;
+	std::string operation;
+	std::string element_type;
+	std::size_t n;
+
+	double ns_per_op;
+	double allocations_per_op;
+	double bytes_per_op;
+
+	// Hardware counters per operation, when the run measured them.
+	std::vector<std::pair<std::string, double>> counters;
+};
+
+struct bench_regression {
+	std::string name;
+	std::string metric;
+	double baseline;
+	double candidate;
+};
+
+namespace bench_report_detail {
+
+	inline auto quoted(const std::string& text) -> std::string {
+		auto result = std::string{"\""};
+		for(auto c : text) {
+			if(c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result + '"';
+	}
+
+	inline auto field(const std::string& line, const std::string& key) -> std::string {
+		auto position = line.find(quoted(key) + ":");
+		if(position == std::string::npos)
+			return {};
+		position = line.find_first_not_of(' ', position + key.size() + 3);
+		if(position == std::string::npos)
+			return {};
+		if(line[position] != '"')
+			return line.substr(position, line.find_first_of(",}", position) - position);
+		auto value = std::string{};
+		for(++position; position < line.size() && line[position] != '"'; ++position) {
+			if(line[position] == '\\')
+				++position;
+			value += line[position];
+		}
+		return value;
+	}
+
+	inline auto counters(const std::string& line) -> std::vector<std::pair<std::string, double>> {
+		auto result = std::vector<std::pair<std::string, double>>{};
+		auto position = line.find(quoted("counters") + ": {");
+		if(position == std::string::npos)
+			return result;
+		auto last = line.find('}', position);
+		for(position = line.find('"', position + 12); position < last; position = line.find('"', position)) {
+			auto key_end = line.find('"', position + 1);
+			auto key = line.substr(position + 1, key_end - position - 1);
+			result.emplace_back(key, std::strtod(field(line, key).c_str(), nullptr));
+			position = line.find_first_of(",}", key_end);
+		}
+		return result;
+	}
+}
+
+inline auto write_bench_results(std::ostream& out, const std::vector<bench_result>& results) -> void {
+	using bench_report_detail::quoted;
+
+	auto previous_precision = out.precision(12);
+	out << "{\"results\": [\n";
+	for(auto i = std::size_t{0}; i < results.size(); ++i) {
+		auto& result = results[i];
+		out << "  {\"name\": " << quoted(result.name)
+			<< ", \"container\": " << quoted(result.container)
+			<< ", \"operation\": " << quoted(result.operation)
+			<< ", \"element_type\": " << quoted(result.element_type)
+			<< ", \"n\": " << result.n
+			<< ", \"ns_per_op\": " << result.ns_per_op
+			<< ", \"allocations_per_op\": " << result.allocations_per_op
+			<< ", \"bytes_per_op\": " << result.bytes_per_op;
+		if(!result.counters.empty()) {
+			out << ", \"counters\": {";
+			for(auto j = std::size_t{0}; j < result.counters.size(); ++j)
+				out << (j == 0 ? "" : ", ") << quoted(result.counters[j].first) << ": " << result.counters[j].second;
+			out << "}";
+		}
+		out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "]}\n";
+	out.precision(previous_precision);
+}
+
+inline auto read_bench_results(std::istream& in) -> std::vector<bench_result> {
+	using bench_report_detail::field;
+
+	auto results = std::vector<bench_result>{};
+	for(auto line = std::string{}; std::getline(in, line);) {
+		auto name = field(line, "name");
+		if(name.empty())
+			continue;
+		results.push_back({
+			name,
+			field(line, "container"),
+			field(line, "operation"),
+			field(line, "element_type"),
+			std::strtoull(field(line, "n").c_str(), nullptr, 10),
+			std::strtod(field(line, "ns_per_op").c_str(), nullptr),
+			std::strtod(field(line, "allocations_per_op").c_str(), nullptr),
+			std::strtod(field(line, "bytes_per_op").c_str(), nullptr),
+			bench_report_detail::counters(line),
+		});
+	}
+	return results;
+}
+
+// Cases of candidate whose time grew by more than threshold (0.1 for 10%)
+// over the baseline case of the same name, or that allocate more.
+inline auto compare_bench_results(
+	const std::vector<bench_result>& baseline,
+	const std::vector<bench_result>& candidate,
+	double threshold
+) -> std::vector<bench_regression> {
+	auto regressions = std::vector<bench_regression>{};
+	for(auto& after : candidate) {
+		for(auto& before : baseline) {
+			if(before.name != after.name)
+				continue;
+			if(after.ns_per_op > before.ns_per_op * (1 + threshold))
+				regressions.push_back({after.name, "ns_per_op", before.ns_per_op, after.ns_per_op});
+			if(after.allocations_per_op > before.allocations_per_op)
+				regressions.push_back({after.name, "allocations_per_op", before.allocations_per_op, after.allocations_per_op});
+			if(after.bytes_per_op > before.bytes_per_op * (1 + threshold))
+				regressions.push_back({after.name, "bytes_per_op", before.bytes_per_op, after.bytes_per_op});
+		}
+	}
+	return regressions;
+}
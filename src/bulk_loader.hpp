@@ -0,0 +1,343 @@
+#pragma once
+
+#include<algorithm>
+#include<atomic>
+#include<cerrno>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<exception>
+#include<future>
+#include<mutex>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<thread>
+#include<type_traits>
+#include<vector>
+
+#include<sys/types.h>
+#include<unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VECTOR_IO_URING
+#include<linux/io_uring.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#endif
+
+#include "vector.hpp"
+
+// Fills a presized vector of trivially copyable values from ranges of files,
+// read one after the other into its bytes. The ranges are cut into chunks
+// read in parallel straight into data() : through io_uring with up to
+// queue_depth reads in flight where the kernel allows it, by a pool of
+// threads calling pread otherwise. load_async returns at once, and its
+// future becomes ready, or holds the error, once every byte is in place.
+
+struct file_range {
+	int descriptor;
+	off_t offset;
+	std::size_t bytes;
+};
+
+struct bulk_load_options {
+	std::size_t chunk_bytes = 1 << 20;
+	unsigned queue_depth = 32;
+	unsigned threads = 4;
+	bool io_uring = true;
+};
+
+namespace bulk_loader_detail {
+
+	struct chunk {
+		int descriptor;
+		off_t offset;
+		char* to;
+		std::size_t bytes;
+	};
+
+	[[noreturn]]
+	inline auto throw_error(int error, const char* call) -> void {
+		throw std::system_error{error, std::generic_category(), std::string{"load_async : "} + call};
+	}
+
+	inline auto make_chunks(char* to, const std::vector<file_range>& ranges, std::size_t chunk_bytes) -> std::vector<chunk> {
+		auto chunks = std::vector<chunk>{};
+		for(auto& range : ranges) {
+			for(auto done = std::size_t{0}; done < range.bytes; done += chunk_bytes) {
+				auto bytes = std::min(chunk_bytes, range.bytes - done);
+				chunks.push_back({range.descriptor, range.offset + static_cast<off_t>(done), to, bytes});
+				to += bytes;
+			}
+		}
+		return chunks;
+	}
+
+	// Marks bytes read, and throws when a chunk ends before the file does.
+	inline auto advance(chunk& c, std::size_t bytes) -> void {
+		if(bytes == 0)
+			throw std::runtime_error{"load_async : file truncated"};
+		c.offset += static_cast<off_t>(bytes);
+		c.to += bytes;
+		c.bytes -= bytes;
+	}
+
+	inline auto read_with_threads(std::vector<chunk>& chunks, unsigned threads) -> void {
+		auto next = std::atomic<std::size_t>{0};
+		auto failed = std::atomic<bool>{false};
+		auto error = std::exception_ptr{};
+		auto error_mutex = std::mutex{};
+
+		auto work = [&] {
+			try {
+				for(auto i = next++; i < chunks.size() && !failed; i = next++) {
+					auto& c = chunks[i];
+					while(c.bytes > 0) {
+						auto got = ::pread(c.descriptor, c.to, c.bytes, c.offset);
+						if(got < 0 && errno == EINTR)
+							continue;
+						if(got < 0)
+							throw_error(errno, "pread");
+						advance(c, static_cast<std::size_t>(got));
+					}
+				}
+			}
+			catch(...) {
+				auto lock = std::lock_guard<std::mutex>{error_mutex};
+				if(!error)
+					error = std::current_exception();
+				failed = true;
+			}
+		};
+
+		auto pool = std::vector<std::thread>{};
+		auto count = std::min<std::size_t>(std::max(threads, 1u), chunks.size());
+		for(auto i = std::size_t{1}; i < count; ++i)
+			pool.emplace_back(work);
+		work();
+		for(auto& thread : pool)
+			thread.join();
+		if(error)
+			std::rethrow_exception(error);
+	}
+
+#ifdef VECTOR_IO_URING
+	// Just enough of io_uring for reads, on the raw system calls.
+	class ring {
+	public:
+
+		explicit
+		ring(unsigned entries) noexcept {
+			auto params = io_uring_params{};
+			descriptor_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+			if(descriptor_ < 0)
+				return;
+
+			sq_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cq_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if(single)
+				sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+			sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+
+			sq_ = map(sq_bytes_, IORING_OFF_SQ_RING);
+			cq_ = single ? sq_ : map(cq_bytes_, IORING_OFF_CQ_RING);
+			sqes_ = static_cast<io_uring_sqe*>(map(sqes_bytes_, IORING_OFF_SQES));
+			if(sq_ == nullptr || cq_ == nullptr || sqes_ == nullptr) {
+				close();
+				return;
+			}
+
+			entries_ = params.sq_entries;
+			sq_tail_ = field(sq_, params.sq_off.tail);
+			sq_mask_ = *field(sq_, params.sq_off.ring_mask);
+			sq_array_ = field(sq_, params.sq_off.array);
+			cq_head_ = field(cq_, params.cq_off.head);
+			cq_tail_ = field(cq_, params.cq_off.tail);
+			cq_mask_ = *field(cq_, params.cq_off.ring_mask);
+			cqes_ = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cq_) + params.cq_off.cqes);
+		}
+
+		ring(const ring&) = delete;
+
+		auto operator=(const ring&) -> ring& = delete;
+
+		~ring() {
+			close();
+		}
+
+		auto available() const noexcept -> bool {
+			return descriptor_ >= 0;
+		}
+
+		auto entries() const noexcept -> unsigned {
+			return entries_;
+		}
+
+		// Queues a read, submitted by the next wait().
+		auto read(const chunk& c, std::uint64_t user_data) noexcept -> void {
+			auto tail = *sq_tail_;
+			auto index = tail & sq_mask_;
+			auto& sqe = sqes_[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_READ;
+			sqe.fd = c.descriptor;
+			sqe.addr = reinterpret_cast<std::uint64_t>(c.to);
+			sqe.len = static_cast<std::uint32_t>(std::min<std::size_t>(c.bytes, 1u << 30));
+			sqe.off = static_cast<std::uint64_t>(c.offset);
+			sqe.user_data = user_data;
+			sq_array_[index] = index;
+			__atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+			pending_ += 1;
+		}
+
+		// Submits the queued reads and waits for at least one completion.
+		auto wait() -> void {
+			auto submitted = ::syscall(__NR_io_uring_enter, descriptor_, pending_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if(submitted < 0 && errno != EINTR)
+				throw_error(errno, "io_uring_enter");
+			if(submitted > 0)
+				pending_ -= static_cast<unsigned>(submitted);
+		}
+
+		// Calls on_completion(user_data, result) for every completed read.
+		template<class OnCompletion>
+		auto reap(OnCompletion on_completion) -> void {
+			auto head = *cq_head_;
+			auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+			for(; head != tail; ++head) {
+				auto& cqe = cqes_[head & cq_mask_];
+				auto user_data = cqe.user_data;
+				auto result = cqe.res;
+				__atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+				on_completion(user_data, result);
+			}
+		}
+
+	private:
+
+		static auto field(void* base, unsigned offset) noexcept -> unsigned* {
+			return reinterpret_cast<unsigned*>(static_cast<char*>(base) + offset);
+		}
+
+		auto map(std::size_t bytes, off_t offset) noexcept -> void* {
+			auto mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor_, offset);
+			return mapping == MAP_FAILED ? nullptr : mapping;
+		}
+
+		auto close() noexcept -> void {
+			if(sqes_ != nullptr)
+				::munmap(sqes_, sqes_bytes_);
+			if(cq_ != nullptr && cq_ != sq_)
+				::munmap(cq_, cq_bytes_);
+			if(sq_ != nullptr)
+				::munmap(sq_, sq_bytes_);
+			if(descriptor_ >= 0)
+				::close(descriptor_);
+			descriptor_ = -1;
+			sq_ = cq_ = nullptr;
+			sqes_ = nullptr;
+		}
+
+		int descriptor_ = -1;
+		unsigned entries_ = 0;
+		unsigned pending_ = 0;
+
+		void* sq_ = nullptr;
+		void* cq_ = nullptr;
+		io_uring_sqe* sqes_ = nullptr;
+		std::size_t sq_bytes_ = 0;
+		std::size_t cq_bytes_ = 0;
+		std::size_t sqes_bytes_ = 0;
+
+		unsigned* sq_tail_ = nullptr;
+		unsigned sq_mask_ = 0;
+		unsigned* sq_array_ = nullptr;
+		unsigned* cq_head_ = nullptr;
+		unsigned* cq_tail_ = nullptr;
+		unsigned cq_mask_ = 0;
+		io_uring_cqe* cqes_ = nullptr;
+	};
+
+	// Keeps up to the ring's size of reads in flight, and reissues the rest
+	// of a chunk after a short read.
+	inline auto read_with_ring(ring& r, std::vector<chunk>& chunks) -> void {
+		auto next = std::size_t{0};
+		auto in_flight = 0u;
+		auto error = std::exception_ptr{};
+		while(next < chunks.size() || in_flight > 0) {
+			for(; !error && next < chunks.size() && in_flight < r.entries(); ++next, ++in_flight)
+				r.read(chunks[next], next);
+			r.wait();
+			r.reap([&](std::uint64_t index, int result) {
+				in_flight -= 1;
+				auto& c = chunks[index];
+				try {
+					if(result < 0)
+						throw_error(-result, "read");
+					advance(c, static_cast<std::size_t>(result));
+				}
+				catch(...) {
+					if(!error)
+						error = std::current_exception();
+					return;
+				}
+				if(c.bytes > 0 && !error) {
+					r.read(c, index);
+					in_flight += 1;
+				}
+			});
+			if(error && in_flight == 0)
+				break;
+		}
+		if(error)
+			std::rethrow_exception(error);
+	}
+#endif
+
+	inline auto read_chunks(std::vector<chunk> chunks, bulk_load_options options) -> void {
+#ifdef VECTOR_IO_URING
+		if(options.io_uring) {
+			auto r = ring{std::max(options.queue_depth, 1u)};
+			if(r.available())
+				return read_with_ring(r, chunks);
+		}
+#endif
+		read_with_threads(chunks, options.threads);
+	}
+
+	inline auto io_uring_available() noexcept -> bool {
+#ifdef VECTOR_IO_URING
+		return ring{1}.available();
+#else
+		return false;
+#endif
+	}
+}
+
+// Whether load_async can use io_uring here, or falls back to threads.
+inline auto io_uring_available() noexcept -> bool {
+	static auto available = bulk_loader_detail::io_uring_available();
+	return available;
+}
+
+// The ranges must add up to exactly the bytes of into, which must not be
+// resized or destroyed before the future is ready.
+template<class Value, class Allocator>
+auto load_async(
+	vector<Value, Allocator>& into,
+	const std::vector<file_range>& ranges,
+	bulk_load_options options = {}
+) -> std::future<void> {
+	static_assert(std::is_trivially_copyable_v<Value>, "load_async : Value must be trivially copyable");
+	auto bytes = std::size_t{0};
+	for(auto& range : ranges)
+		bytes += range.bytes;
+	if(bytes != into.size() * sizeof(Value))
+		throw std::length_error{"load_async : ranges do not match the size of the vector"};
+
+	auto chunks = bulk_loader_detail::make_chunks(
+		reinterpret_cast<char*>(into.data()), ranges, std::max<std::size_t>(options.chunk_bytes, 1));
+	return std::async(std::launch::async, bulk_loader_detail::read_chunks, std::move(chunks), options);
+}
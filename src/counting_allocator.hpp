@@ -0,0 +1,82 @@
+#pragma once
+
+#include<cstddef>
+#include<memory>
+#include<new>
+
+// Allocator for tests and benchmarks that records every call in a shared
+// allocation_counter, and refuses to allocate once the counter is sealed,
+// i.e. once warmup is done and the steady state must not touch the heap.
+
+struct allocation_counter {
+	std::size_t allocations = 0;
+	std::size_t deallocations = 0;
+	std::size_t bytes = 0;
+	std::size_t forbidden_allocations = 0;
+
+	bool sealed = false;
+
+	auto seal() noexcept -> void {
+		sealed = true;
+	}
+
+	auto unseal() noexcept -> void {
+		sealed = false;
+	}
+};
+
+struct forbidden_allocation : std::bad_alloc {
+	auto what() const noexcept -> const char* override {
+		return "allocation after allocation_counter::seal()";
+	}
+};
+
+template<class Value>
+class counting_allocator {
+public:
+
+	using value_type = Value;
+
+	explicit
+	counting_allocator(allocation_counter& with_counter) noexcept
+		: counter_{&with_counter}
+	{}
+
+	template<class Other>
+	counting_allocator(const counting_allocator<Other>& from_allocator) noexcept
+		: counter_{from_allocator.counter()}
+	{}
+
+	auto allocate(std::size_t n) -> Value* {
+		if(counter_->sealed) {
+			counter_->forbidden_allocations += 1;
+			throw forbidden_allocation{};
+		}
+		counter_->allocations += 1;
+		counter_->bytes += n * sizeof(Value);
+		return std::allocator<Value>{}.allocate(n);
+	}
+
+	auto deallocate(Value* p, std::size_t n) noexcept -> void {
+		counter_->deallocations += 1;
+		std::allocator<Value>{}.deallocate(p, n);
+	}
+
+	auto counter() const noexcept -> allocation_counter* {
+		return counter_;
+	}
+
+private:
+
+	allocation_counter* counter_;
+};
+
+template<class Value, class Other>
+auto operator==(const counting_allocator<Value>& x, const counting_allocator<Other>& y) noexcept -> bool {
+	return x.counter() == y.counter();
+}
+
+template<class Value, class Other>
+auto operator!=(const counting_allocator<Value>& x, const counting_allocator<Other>& y) noexcept -> bool {
+	return !(x == y);
+}
@@ -0,0 +1,453 @@
+#pragma once
+
+#include<algorithm>
+#include<initializer_list>
+#include<iterator>
+#include<memory>
+#include<stdexcept>
+
+#include "vector.hpp"
+#include "vector_stats.hpp"
+
+// Contiguous vector with free capacity at both ends : elements live in
+// [front_, front_ + size_) of the buffer, so push_front is amortized O(1)
+// like push_back. Growing at one end keeps the free capacity of the other.
+
+template<class Value, class Allocator = std::allocator<Value>>
+class devector {
+public:
+
+	// types
+
+	using value_type = Value;
+	using allocator_type = Allocator;
+	using pointer = typename std::allocator_traits<Allocator>::pointer;
+	using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = typename std::allocator_traits<Allocator>::size_type;
+	using difference_type = typename std::allocator_traits<Allocator>::difference_type;
+	using iterator = Value*;
+	using const_iterator = const Value*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	devector() noexcept(noexcept(Allocator()))
+		: devector(Allocator())
+	{}
+
+	explicit
+	devector(const Allocator& with_allocator) noexcept
+		: capacity_{0}
+		, front_{0}
+		, size_{0}
+
+		, allocator_{with_allocator}
+		, data_{nullptr}
+	{}
+
+	devector(std::initializer_list<Value> values, const Allocator& with_allocator = Allocator())
+		: devector(with_allocator)
+	{
+		reserve(values.size());
+		for(auto& value : values)
+			push_back(value);
+	}
+
+	devector(const devector& from_vector)
+		: devector(
+			std::allocator_traits<Allocator>::select_on_container_copy_construction(
+				from_vector.allocator_))
+	{
+		reserve(from_vector.size());
+		for(auto& value : from_vector)
+			push_back(value);
+	}
+
+	devector(devector&& from_vector) noexcept
+		: capacity_{from_vector.capacity_}
+		, front_{from_vector.front_}
+		, size_{from_vector.size_}
+
+		, allocator_{from_vector.allocator_}
+		, data_{from_vector.data_}
+	{
+		from_vector.capacity_ = 0;
+		from_vector.front_ = 0;
+		from_vector.size_ = 0;
+		from_vector.data_ = nullptr;
+	}
+
+	~devector() {
+		clear();
+		deallocate(data_, capacity_);
+	}
+
+	auto operator=(devector from_vector) noexcept -> devector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	auto get_allocator() const noexcept -> allocator_type {
+		return allocator_;
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return vector_detail::to_address(data_) + front_;
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return vector_detail::to_address(data_) + front_;
+	}
+
+	auto end() noexcept -> iterator {
+		return begin() + size_;
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return begin() + size_;
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size_ == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return size_;
+	}
+
+	auto max_size() const noexcept -> size_type {
+		return std::allocator_traits<Allocator>::max_size(allocator_);
+	}
+
+	auto capacity() const noexcept -> size_type {
+		return capacity_;
+	}
+
+	// Elements that push_front can add without reallocating.
+	auto front_free_capacity() const noexcept -> size_type {
+		return front_;
+	}
+
+	// Elements that push_back can add without reallocating.
+	auto back_free_capacity() const noexcept -> size_type {
+		return capacity_ - front_ - size_;
+	}
+
+	auto resize(size_type new_size) -> void {
+		reserve(new_size);
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back();
+	}
+
+	auto resize(size_type new_size, const Value& to_copy) -> void {
+		reserve(new_size);
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back(to_copy);
+	}
+
+	// Makes room for new_capacity elements without moving begin(), so that
+	// push_back does not reallocate until size() reaches new_capacity.
+	auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > max_size())
+			throw std::length_error{"devector::reserve : new_capacity > max_size()"};
+
+		if(new_capacity > size() + back_free_capacity())
+			relocate(front_ + new_capacity, front_);
+	}
+
+	// Same as reserve, for push_front : prepending up to new_capacity - size()
+	// elements, e.g. headers in front of a payload, will not reallocate.
+	auto reserve_front(size_type new_capacity) -> void {
+		if(new_capacity > max_size())
+			throw std::length_error{"devector::reserve_front : new_capacity > max_size()"};
+
+		if(new_capacity > size() + front_free_capacity())
+			relocate(new_capacity + back_free_capacity(), new_capacity - size());
+	}
+
+	// Keeps the buffer when a new one would come back as large.
+	auto shrink_to_fit() -> void {
+		if(capacity() > vector_detail::allocation_size(allocator_, size()))
+			relocate(size(), 0);
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return begin()[index];
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		return begin()[index];
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("devector::at : index >= size()");
+		return begin()[index];
+	}
+
+	auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("devector::at : index >= size()");
+		return begin()[index];
+	}
+
+	auto front() -> reference {
+		return begin()[0];
+	}
+
+	auto front() const -> const_reference {
+		return begin()[0];
+	}
+
+	auto back() -> reference {
+		return begin()[size() - 1];
+	}
+
+	auto back() const -> const_reference {
+		return begin()[size() - 1];
+	}
+
+	// data access
+
+	auto data() noexcept -> Value* {
+		return begin();
+	}
+
+	auto data() const noexcept -> const Value* {
+		return begin();
+	}
+
+	// modifiers
+
+	template<class... Args>
+	auto emplace_front(Args&&... args) -> reference {
+		if(front_ == 0) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			grow_front();
+			return emplace_front(std::move(to_emplace));
+		}
+		std::allocator_traits<Allocator>::construct(allocator_, begin() - 1, std::forward<Args>(args)...);
+		front_ -= 1;
+		resize_by(1);
+		return front();
+	}
+
+	auto push_front(const Value& to_push) -> void {
+		emplace_front(to_push);
+	}
+
+	auto push_front(Value&& to_push) -> void {
+		emplace_front(std::move(to_push));
+	}
+
+	auto pop_front() -> void {
+		std::allocator_traits<Allocator>::destroy(allocator_, begin());
+		front_ += 1;
+		resize_by(-1);
+	}
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		if(back_free_capacity() == 0) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			grow_back();
+			return emplace_back(std::move(to_emplace));
+		}
+		std::allocator_traits<Allocator>::construct(allocator_, end(), std::forward<Args>(args)...);
+		resize_by(1);
+		return back();
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	auto pop_back() -> void {
+		std::allocator_traits<Allocator>::destroy(allocator_, end() - 1);
+		resize_by(-1);
+	}
+
+	// Shifts the shorter side of position when it has room, the other side
+	// otherwise.
+	template<class... Args>
+	auto emplace(const_iterator position, Args&&... args) -> iterator {
+		auto index = static_cast<size_type>(position - cbegin());
+		if(index == 0) {
+			emplace_front(std::forward<Args>(args)...);
+			return begin();
+		}
+		if(index == size()) {
+			emplace_back(std::forward<Args>(args)...);
+			return end() - 1;
+		}
+
+		auto to_emplace = Value(std::forward<Args>(args)...);
+		if(back_free_capacity() == 0 && front_ == 0)
+			grow_back();
+		if(front_ > 0 && (index < size() / 2 || back_free_capacity() == 0)) {
+			std::allocator_traits<Allocator>::construct(allocator_, begin() - 1, std::move(front()));
+			front_ -= 1;
+			std::move(begin() + 2, begin() + index + 1, begin() + 1);
+		}
+		else {
+			std::allocator_traits<Allocator>::construct(allocator_, end(), std::move(back()));
+			std::move_backward(begin() + index, end() - 1, end());
+		}
+		resize_by(1);
+		begin()[index] = std::move(to_emplace);
+		return begin() + index;
+	}
+
+	auto insert(const_iterator position, const Value& to_insert) -> iterator {
+		return emplace(position, to_insert);
+	}
+
+	auto insert(const_iterator position, Value&& to_insert) -> iterator {
+		return emplace(position, std::move(to_insert));
+	}
+
+	auto erase(const_iterator position) -> iterator {
+		return erase(position, position + 1);
+	}
+
+	// Shifts whichever side of the erased range is shorter.
+	auto erase(const_iterator first, const_iterator last) -> iterator {
+		auto index = static_cast<size_type>(first - cbegin());
+		auto count = static_cast<size_type>(last - first);
+		if(index < size() - index - count) {
+			std::move_backward(begin(), begin() + index, begin() + index + count);
+			for(auto i = size_type{0}; i < count; ++i)
+				pop_front();
+		}
+		else {
+			std::move(begin() + index + count, end(), begin() + index);
+			for(auto i = size_type{0}; i < count; ++i)
+				pop_back();
+		}
+		return begin() + index;
+	}
+
+	auto swap(devector& to_swap) noexcept -> void {
+		std::swap(capacity_, to_swap.capacity_);
+		std::swap(front_, to_swap.front_);
+		std::swap(size_, to_swap.size_);
+		std::swap(allocator_, to_swap.allocator_);
+		std::swap(data_, to_swap.data_);
+	}
+
+	// Keeps the front free capacity.
+	auto clear() noexcept -> void {
+		for(auto it = begin(); it != end(); ++it)
+			std::allocator_traits<Allocator>::destroy(allocator_, it);
+		probe::resized(size_, 0);
+		size_ = 0;
+	}
+
+private:
+
+	using probe = vector_probe<devector>;
+
+	auto resize_by(difference_type delta) noexcept -> void {
+		probe::resized(size_, size_ + delta);
+		size_ += delta;
+	}
+
+	// Growth at one end is geometric in the whole capacity, and leaves the
+	// free capacity at the other end as it was.
+
+	auto grow_front() -> void {
+		auto new_capacity = 2 * capacity() + 1;
+		relocate(new_capacity, new_capacity - size() - back_free_capacity());
+	}
+
+	auto grow_back() -> void {
+		relocate(2 * capacity() + 1, front_);
+	}
+
+	// Capacity the allocator adds beyond new_capacity goes to the back.
+	auto relocate(size_type new_capacity, size_type new_front) -> void {
+		auto previous_data = data_;
+		auto previous_capacity = capacity_;
+		auto previous_begin = begin();
+		data_ = new_capacity == 0 ? pointer{} : allocate(new_capacity);
+		capacity_ = new_capacity;
+		front_ = new_front;
+
+		vector_detail::relocate(allocator_, previous_begin, size(), begin());
+
+		if(previous_data != nullptr)
+			probe::reallocated(size(), size() * sizeof(Value));
+		deallocate(previous_data, previous_capacity);
+	}
+
+	// Allocates at least n elements, and sets n to the number allocated.
+	auto allocate(size_type& n) -> pointer {
+		return vector_detail::allocate<probe>(allocator_, n, false);
+	}
+
+	auto deallocate(pointer p, size_type n) -> void {
+		vector_detail::deallocate<probe>(allocator_, p, n);
+	}
+
+	size_type capacity_;
+	size_type front_;
+	size_type size_;
+
+	Allocator allocator_;
+	pointer data_;
+};
+
+template<class Value, class Allocator>
+void swap(devector<Value, Allocator>& x, devector<Value, Allocator>& y) noexcept {
+	x.swap(y);
+}
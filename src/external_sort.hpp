@@ -0,0 +1,340 @@
+#pragma once
+
+#include<algorithm>
+#include<cerrno>
+#include<cstddef>
+#include<exception>
+#include<filesystem>
+#include<functional>
+#include<optional>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<thread>
+#include<type_traits>
+#include<utility>
+#include<vector>
+
+#include<fcntl.h>
+#include<unistd.h>
+
+// Sorts a vector of trivially copyable values that may not fit in memory,
+// e.g. an external_vector or an mmap_vector, holding about memory_budget
+// bytes of values at a time. Chunks of the vector are read in order, cut in
+// one slice per thread, sorted and merged in memory in parallel, and written
+// as one sorted run each to an unlinked temporary file. The runs are then
+// merged k-way through buffered reads of at least min_merge_buffer_bytes,
+// in as many passes as the budget needs, the last one writing the result
+// back in order. Only size() and
+// operator[] of the vector are used, both in sequential order, and reads go
+// through the const operator[], so as not to mark pages as modified.
+
+namespace external_sort_detail {
+
+	[[noreturn]]
+	inline auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"external_sort : "} + call};
+	}
+
+	class temporary_file {
+	public:
+
+		temporary_file() {
+			auto path = (std::filesystem::temp_directory_path() / "external_sort_XXXXXX").string();
+			descriptor_ = ::mkstemp(path.data());
+			if(descriptor_ < 0)
+				throw_errno("mkstemp");
+			::unlink(path.c_str());
+		}
+
+		temporary_file(const temporary_file&) = delete;
+
+		auto operator=(const temporary_file&) -> temporary_file& = delete;
+
+		~temporary_file() {
+			::close(descriptor_);
+		}
+
+		auto write(const void* from, std::size_t bytes, off_t offset) -> void {
+			auto position = static_cast<const char*>(from);
+			while(bytes > 0) {
+				auto written = ::pwrite(descriptor_, position, bytes, offset);
+				if(written < 0 && errno == EINTR)
+					continue;
+				if(written < 0)
+					throw_errno("pwrite");
+				position += written;
+				offset += written;
+				bytes -= static_cast<std::size_t>(written);
+			}
+		}
+
+		auto read(void* to, std::size_t bytes, off_t offset) -> void {
+			auto position = static_cast<char*>(to);
+			while(bytes > 0) {
+				auto got = ::pread(descriptor_, position, bytes, offset);
+				if(got < 0 && errno == EINTR)
+					continue;
+				if(got < 0)
+					throw_errno("pread");
+				if(got == 0)
+					throw std::runtime_error{"external_sort : run file truncated"};
+				position += got;
+				offset += got;
+				bytes -= static_cast<std::size_t>(got);
+			}
+		}
+
+	private:
+
+		int descriptor_;
+	};
+
+	// Smallest read buffer of a run in the merge : with less, reads stop
+	// being large and sequential, so the merge takes more passes instead.
+	constexpr std::size_t min_merge_buffer_bytes = 64 * 1024;
+
+	struct run {
+		std::size_t begin;
+		std::size_t size;
+	};
+
+	// Runs task(i) for every i in [0, count), each on its own thread. An
+	// exception thrown by a task, e.g. by the comparison, is rethrown here
+	// once every thread is joined, instead of terminating the program.
+	template<class Task>
+	auto run_parallel(std::size_t count, Task& task) -> void {
+		auto errors = std::vector<std::exception_ptr>(count);
+		auto workers = std::vector<std::thread>{};
+		workers.reserve(count);
+		auto join = [&] {
+			for(auto& worker : workers)
+				worker.join();
+		};
+		try {
+			for(auto i = std::size_t{0}; i < count; ++i)
+				workers.emplace_back([&task, &errors, i] {
+					try {
+						task(i);
+					}
+					catch(...) {
+						errors[i] = std::current_exception();
+					}
+				});
+		}
+		catch(...) {
+			join();
+			throw;
+		}
+		join();
+		for(auto& error : errors)
+			if(error)
+				std::rethrow_exception(error);
+	}
+
+	// Sorts one slice of chunk per thread, then merges neighbouring slices
+	// pairwise, the merges of a round in parallel.
+	template<class Value, class Compare>
+	auto sort_chunk(std::vector<Value>& chunk, unsigned threads, Compare& compare) -> void {
+		auto slice_size = (chunk.size() + threads - 1) / threads;
+		auto slices = (chunk.size() + slice_size - 1) / slice_size;
+		auto at = [&](std::size_t slice) {
+			return chunk.begin() + static_cast<std::ptrdiff_t>(std::min(slice * slice_size, chunk.size()));
+		};
+
+		auto sort = [&](std::size_t slice) {
+			std::sort(at(slice), at(slice + 1), compare);
+		};
+		run_parallel(slices, sort);
+		for(auto width = std::size_t{1}; width < slices; width *= 2) {
+			auto merge = [&](std::size_t pair) {
+				auto first = 2 * width * pair;
+				std::inplace_merge(at(first), at(first + width), at(first + 2 * width), compare);
+			};
+			run_parallel((slices + 2 * width - 1) / (2 * width), merge);
+		}
+	}
+
+	// Reads a sorted run buffer by buffer.
+	template<class Value>
+	class run_reader {
+	public:
+
+		run_reader(temporary_file& with_file, run with_run, std::size_t buffer_size)
+			: file_{&with_file}
+			, next_{with_run.begin}
+			, end_{with_run.begin + with_run.size}
+			, buffer_(std::min(buffer_size, with_run.size))
+			, position_{0}
+		{
+			refill();
+		}
+
+		auto current() const noexcept -> const Value& {
+			return buffer_[position_];
+		}
+
+		// Moves to the next value, and returns false past the end of the run.
+		auto advance() -> bool {
+			position_ += 1;
+			if(position_ < buffer_.size())
+				return true;
+			if(next_ == end_)
+				return false;
+			refill();
+			return true;
+		}
+
+	private:
+
+		auto refill() -> void {
+			buffer_.resize(std::min(buffer_.capacity(), end_ - next_));
+			file_->read(buffer_.data(), buffer_.size() * sizeof(Value), static_cast<off_t>(next_ * sizeof(Value)));
+			next_ += buffer_.size();
+			position_ = 0;
+		}
+
+		temporary_file* file_;
+		std::size_t next_;
+		std::size_t end_;
+		std::vector<Value> buffer_;
+		std::size_t position_;
+	};
+
+	// Writes a run buffer by buffer, from index begin of the file on.
+	template<class Value>
+	class run_writer {
+	public:
+
+		run_writer(temporary_file& with_file, std::size_t with_begin, std::size_t buffer_size)
+			: file_{&with_file}
+			, next_{with_begin}
+		{
+			buffer_.reserve(buffer_size);
+		}
+
+		auto push(const Value& to_push) -> void {
+			buffer_.push_back(to_push);
+			if(buffer_.size() == buffer_.capacity())
+				flush();
+		}
+
+		auto flush() -> void {
+			file_->write(buffer_.data(), buffer_.size() * sizeof(Value), static_cast<off_t>(next_ * sizeof(Value)));
+			next_ += buffer_.size();
+			buffer_.clear();
+		}
+
+	private:
+
+		temporary_file* file_;
+		std::size_t next_;
+		std::vector<Value> buffer_;
+	};
+
+	// Merges the runs [first, last) of file, passing each value in order to
+	// output.
+	template<class Value, class Compare, class Output>
+	auto merge_runs(
+		temporary_file& file,
+		const run* first,
+		const run* last,
+		std::size_t buffer_size,
+		Compare& compare,
+		Output output
+	) -> void {
+		auto readers = std::vector<run_reader<Value>>{};
+		readers.reserve(static_cast<std::size_t>(last - first));
+		for(auto r = first; r != last; ++r)
+			readers.emplace_back(file, *r, buffer_size);
+
+		// Min-heap of reader indices on their current values.
+		auto heap = std::vector<std::size_t>{};
+		for(auto i = std::size_t{0}; i < readers.size(); ++i)
+			heap.push_back(i);
+		auto later = [&](std::size_t x, std::size_t y) {
+			return compare(readers[y].current(), readers[x].current());
+		};
+		std::make_heap(heap.begin(), heap.end(), later);
+
+		while(!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end(), later);
+			auto& reader = readers[heap.back()];
+			output(reader.current());
+			if(reader.advance())
+				std::push_heap(heap.begin(), heap.end(), later);
+			else
+				heap.pop_back();
+		}
+	}
+}
+
+template<class VectorLike, class Compare = std::less<>>
+auto external_sort(
+	VectorLike& values,
+	std::size_t memory_budget,
+	Compare compare = {},
+	unsigned threads = std::thread::hardware_concurrency()
+) -> void {
+	using value_type = typename VectorLike::value_type;
+	static_assert(std::is_trivially_copyable_v<value_type>, "external_sort : value_type must be trivially copyable");
+	using namespace external_sort_detail;
+
+	auto size = static_cast<std::size_t>(values.size());
+	if(size < 2)
+		return;
+	threads = std::max(threads, 1u);
+	auto chunk_size = std::max<std::size_t>(memory_budget / sizeof(value_type), threads);
+
+	// sorted runs
+
+	auto file = temporary_file{};
+	auto runs = std::vector<run>{};
+	{
+		auto chunk = std::vector<value_type>{};
+		chunk.reserve(std::min(chunk_size, size));
+		for(auto begin = std::size_t{0}; begin < size; begin += chunk.size()) {
+			chunk.clear();
+			for(auto i = begin; i < size && chunk.size() < chunk_size; ++i)
+				chunk.push_back(std::as_const(values)[i]);
+			sort_chunk(chunk, threads, compare);
+			runs.push_back({begin, chunk.size()});
+			file.write(chunk.data(), chunk.size() * sizeof(value_type), static_cast<off_t>(begin * sizeof(value_type)));
+		}
+	}
+
+	// k-way merge
+
+	auto min_buffer = std::max<std::size_t>(min_merge_buffer_bytes / sizeof(value_type), 1);
+	auto fan_in = std::max<std::size_t>(memory_budget / sizeof(value_type) / min_buffer, 2);
+	auto buffer_size = [&](std::size_t merged) {
+		return std::max(memory_budget / sizeof(value_type) / merged, min_buffer);
+	};
+
+	// Merges fan_in runs at a time into another file, where each merged run
+	// takes the place of the runs it came from, until one pass is left.
+	auto spare = std::optional<temporary_file>{};
+	auto input = &file;
+	while(runs.size() > fan_in) {
+		if(!spare)
+			spare.emplace();
+		auto output = input == &file ? &*spare : &file;
+		auto merged = std::vector<run>{};
+		for(auto first = std::size_t{0}; first < runs.size(); first += fan_in) {
+			auto last = std::min(first + fan_in, runs.size());
+			auto writer = run_writer<value_type>{*output, runs[first].begin, min_buffer};
+			merge_runs<value_type>(*input, &runs[first], runs.data() + last, buffer_size(last - first), compare, [&](const value_type& value) {
+				writer.push(value);
+			});
+			writer.flush();
+			merged.push_back({runs[first].begin, runs[last - 1].begin + runs[last - 1].size - runs[first].begin});
+		}
+		input = output;
+		runs = std::move(merged);
+	}
+
+	auto out = std::size_t{0};
+	merge_runs<value_type>(*input, runs.data(), runs.data() + runs.size(), buffer_size(runs.size()), compare, [&](const value_type& value) {
+		values[out++] = value;
+	});
+}
@@ -0,0 +1,408 @@
+#pragma once
+
+#include<algorithm>
+#include<cerrno>
+#include<cstddef>
+#include<cstdlib>
+#include<filesystem>
+#include<iterator>
+#include<list>
+#include<memory>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<type_traits>
+#include<unordered_map>
+#include<utility>
+
+#include<fcntl.h>
+#include<unistd.h>
+
+#include "indexed_iterator.hpp"
+
+// Vector of trivially copyable values larger than memory : elements are
+// grouped in pages of about page_bytes, which live in an unlinked temporary
+// file, and at most memory_budget bytes of pages are kept in memory, least
+// recently used first out. Appends and scans read or write each page once;
+// random accesses cost one pread per page missing from the cache. Only
+// writes mark a page to be written back : non-const element access returns
+// a proxy reference, which reads without touching the page's state.
+// Const references point into the cache, and stay valid only until the next
+// access to another page.
+
+template<class Value>
+class external_vector {
+	static_assert(std::is_trivially_copyable_v<Value>, "external_vector : Value must be trivially copyable");
+
+public:
+
+	// types
+
+	class reference;
+
+	using value_type = Value;
+	using const_reference = const value_type&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using iterator = indexed_iterator<external_vector, false>;
+	using const_iterator = indexed_iterator<external_vector, true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	static constexpr std::size_t default_memory_budget = 64 << 20;
+	static constexpr std::size_t default_page_bytes = 1 << 20;
+
+	// Element of a non-const external_vector : reading it converts to a
+	// Value, assigning to it goes through set().
+	class reference {
+	public:
+
+		operator Value() const {
+			return std::as_const(*vector_)[index_];
+		}
+
+		auto operator=(const Value& to_assign) -> reference& {
+			vector_->set(index_, to_assign);
+			return *this;
+		}
+
+		auto operator=(const reference& from_reference) -> reference& {
+			return *this = static_cast<Value>(from_reference);
+		}
+
+	private:
+
+		friend class external_vector;
+
+		reference(external_vector* with_vector, size_type with_index) noexcept
+			: vector_{with_vector}
+			, index_{with_index}
+		{}
+
+		external_vector* vector_;
+		size_type index_;
+	};
+
+	// construct/copy/destroy
+
+	// The temporary file goes to directory, by default the system's one.
+	explicit
+	external_vector(
+		std::size_t memory_budget = default_memory_budget,
+		std::size_t page_bytes = default_page_bytes,
+		const std::filesystem::path& directory = std::filesystem::temp_directory_path()
+	)
+		: page_size_{std::max<size_type>(page_bytes / sizeof(Value), 1)}
+		, max_pages_{std::max<size_type>(memory_budget / (page_size_ * sizeof(Value)), 2)}
+		, size_{0}
+		, descriptor_{-1}
+		, page_writes_{0}
+	{
+		auto path = (directory / "external_vector_XXXXXX").string();
+		descriptor_ = ::mkstemp(path.data());
+		if(descriptor_ < 0)
+			throw_errno("mkstemp");
+		::unlink(path.c_str());
+	}
+
+	external_vector(const external_vector&) = delete;
+
+	external_vector(external_vector&& from_vector) noexcept
+		: page_size_{from_vector.page_size_}
+		, max_pages_{from_vector.max_pages_}
+		, size_{std::exchange(from_vector.size_, 0)}
+		, descriptor_{std::exchange(from_vector.descriptor_, -1)}
+		, page_writes_{std::exchange(from_vector.page_writes_, 0)}
+		, pages_{std::move(from_vector.pages_)}
+		, page_positions_{std::move(from_vector.page_positions_)}
+	{}
+
+	~external_vector() {
+		if(descriptor_ >= 0)
+			::close(descriptor_);
+	}
+
+	auto operator=(external_vector from_vector) noexcept -> external_vector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return iterator{this, 0};
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return const_iterator{this, 0};
+	}
+
+	auto end() noexcept -> iterator {
+		return iterator{this, size()};
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return const_iterator{this, size()};
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size_ == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return size_;
+	}
+
+	// Elements per page.
+	auto page_size() const noexcept -> size_type {
+		return page_size_;
+	}
+
+	auto cached_pages() const noexcept -> size_type {
+		return pages_.size();
+	}
+
+	auto max_cached_pages() const noexcept -> size_type {
+		return max_pages_;
+	}
+
+	// Pages written to the file so far.
+	auto page_writes() const noexcept -> size_type {
+		return page_writes_;
+	}
+
+	auto resize(size_type new_size) -> void {
+		resize(new_size, Value{});
+	}
+
+	auto resize(size_type new_size, const Value& to_copy) -> void {
+		if(new_size < size())
+			size_ = new_size;
+		while(size() < new_size)
+			push_back(to_copy);
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return reference{this, index};
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		return page_for(index / page_size_).values[index % page_size_];
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("external_vector::at : index >= size()");
+		return operator[](index);
+	}
+
+	auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("external_vector::at : index >= size()");
+		return operator[](index);
+	}
+
+	auto front() -> reference {
+		return operator[](0);
+	}
+
+	auto front() const -> const_reference {
+		return operator[](0);
+	}
+
+	auto back() -> reference {
+		return operator[](size() - 1);
+	}
+
+	auto back() const -> const_reference {
+		return operator[](size() - 1);
+	}
+
+	// modifiers
+
+	auto set(size_type index, const Value& to_set) -> void {
+		auto& p = page_for(index / page_size_);
+		p.dirty = true;
+		p.values[index % page_size_] = to_set;
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		auto& p = page_for(size_ / page_size_);
+		p.dirty = true;
+		p.values[size_ % page_size_] = to_push;
+		size_ += 1;
+	}
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		push_back(Value(std::forward<Args>(args)...));
+		return back();
+	}
+
+	auto pop_back() noexcept -> void {
+		size_ -= 1;
+	}
+
+	auto swap(external_vector& to_swap) noexcept -> void {
+		std::swap(page_size_, to_swap.page_size_);
+		std::swap(max_pages_, to_swap.max_pages_);
+		std::swap(size_, to_swap.size_);
+		std::swap(descriptor_, to_swap.descriptor_);
+		std::swap(page_writes_, to_swap.page_writes_);
+		std::swap(pages_, to_swap.pages_);
+		std::swap(page_positions_, to_swap.page_positions_);
+	}
+
+	// Drops the elements, the cache and the file contents.
+	auto clear() -> void {
+		size_ = 0;
+		pages_.clear();
+		page_positions_.clear();
+		if(::ftruncate(descriptor_, 0) != 0)
+			throw_errno("ftruncate");
+	}
+
+	// Writes the modified cached pages to the file, keeping them cached.
+	auto flush() -> void {
+		for(auto& p : pages_)
+			write(p);
+	}
+
+private:
+
+	struct page {
+		size_type index;
+		std::unique_ptr<Value[]> values;
+		bool dirty;
+	};
+
+	[[noreturn]]
+	static auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"external_vector : "} + call};
+	}
+
+	auto page_offset(size_type index) const noexcept -> off_t {
+		return static_cast<off_t>(index * page_size_ * sizeof(Value));
+	}
+
+	// The cached page, loaded first if needed, in place of the least
+	// recently used one when the cache is full.
+	auto page_for(size_type index) const -> page& {
+		if(!pages_.empty() && pages_.front().index == index)
+			return pages_.front();
+
+		auto position = page_positions_.find(index);
+		if(position != page_positions_.end()) {
+			pages_.splice(pages_.begin(), pages_, position->second);
+			return pages_.front();
+		}
+
+		if(pages_.size() < max_pages_)
+			pages_.push_front({index, std::make_unique<Value[]>(page_size_), false});
+		else {
+			auto& evicted = pages_.back();
+			write(evicted);
+			page_positions_.erase(evicted.index);
+			pages_.splice(pages_.begin(), pages_, std::prev(pages_.end()));
+		}
+		// The page is indexed only once loaded, and dropped if loading fails,
+		// so that its buffer is never taken for page index.
+		auto& p = pages_.front();
+		try {
+			read(index, p.values.get());
+			p.index = index;
+			page_positions_[index] = pages_.begin();
+		}
+		catch(...) {
+			pages_.pop_front();
+			throw;
+		}
+		return p;
+	}
+
+	// Reads page index into to. A page past the end of the file reads as
+	// whatever the buffer held.
+	auto read(size_type index, Value* to_values) const -> void {
+		auto bytes = page_size_ * sizeof(Value);
+		auto to = reinterpret_cast<char*>(to_values);
+		for(auto done = std::size_t{0}; done < bytes;) {
+			auto got = ::pread(descriptor_, to + done, bytes - done, page_offset(index) + static_cast<off_t>(done));
+			if(got < 0 && errno == EINTR)
+				continue;
+			if(got < 0)
+				throw_errno("pread");
+			if(got == 0)
+				break;
+			done += static_cast<std::size_t>(got);
+		}
+	}
+
+	auto write(page& p) const -> void {
+		if(!p.dirty)
+			return;
+		auto bytes = page_size_ * sizeof(Value);
+		auto from = reinterpret_cast<const char*>(p.values.get());
+		for(auto done = std::size_t{0}; done < bytes;) {
+			auto written = ::pwrite(descriptor_, from + done, bytes - done, page_offset(p.index) + static_cast<off_t>(done));
+			if(written < 0 && errno == EINTR)
+				continue;
+			if(written < 0)
+				throw_errno("pwrite");
+			done += static_cast<std::size_t>(written);
+		}
+		p.dirty = false;
+		page_writes_ += 1;
+	}
+
+	size_type page_size_;
+	size_type max_pages_;
+	size_type size_;
+	int descriptor_;
+	mutable size_type page_writes_;
+
+	// Most recently used first.
+	mutable std::list<page> pages_;
+	mutable std::unordered_map<size_type, typename std::list<page>::iterator> page_positions_;
+};
+
+template<class Value>
+void swap(external_vector<Value>& x, external_vector<Value>& y) noexcept {
+	x.swap(y);
+}
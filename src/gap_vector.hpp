@@ -0,0 +1,335 @@
+#pragma once
+
+#include<iterator>
+#include<memory>
+#include<stdexcept>
+
+#include "indexed_iterator.hpp"
+
+// Sequence container with a movable gap of free slots inside its buffer.
+// Storage layout : [0, gap_begin_) values, [gap_begin_, gap_end_) gap,
+// [gap_end_, capacity_) values.
+// An insertion or erasure at position p moves the gap to p first, which costs
+// O(|p - previous position|) instead of O(size() - p).
+
+template<class Value, class Allocator = std::allocator<Value>>
+class gap_vector {
+public:
+
+	// types
+
+	using value_type = Value;
+	using allocator_type = Allocator;
+	using pointer = typename std::allocator_traits<Allocator>::pointer;
+	using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = typename std::allocator_traits<Allocator>::size_type;
+	using difference_type = typename std::allocator_traits<Allocator>::difference_type;
+	using iterator = indexed_iterator<gap_vector, false>;
+	using const_iterator = indexed_iterator<gap_vector, true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	gap_vector() noexcept(noexcept(Allocator()))
+		: gap_vector(Allocator())
+	{}
+
+	explicit
+	gap_vector(const Allocator& with_allocator) noexcept
+		: capacity_{0}
+		, gap_begin_{0}
+		, gap_end_{0}
+
+		, allocator_{with_allocator}
+		, data_{nullptr}
+	{}
+
+	gap_vector(const gap_vector& from_vector)
+		: gap_vector(
+			std::allocator_traits<Allocator>::select_on_container_copy_construction(
+				from_vector.allocator_))
+	{
+		reserve(from_vector.size());
+		for(auto& value : from_vector)
+			push_back(value);
+	}
+
+	gap_vector(gap_vector&& from_vector) noexcept
+		: capacity_{from_vector.capacity_}
+		, gap_begin_{from_vector.gap_begin_}
+		, gap_end_{from_vector.gap_end_}
+
+		, allocator_{from_vector.allocator_}
+		, data_{from_vector.data_}
+	{
+		from_vector.capacity_ = 0;
+		from_vector.gap_begin_ = 0;
+		from_vector.gap_end_ = 0;
+		from_vector.data_ = nullptr;
+	}
+
+	~gap_vector() {
+		clear();
+		std::allocator_traits<Allocator>::deallocate(allocator_, data_, capacity_);
+	}
+
+	auto operator=(gap_vector from_vector) noexcept -> gap_vector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	auto get_allocator() const noexcept -> allocator_type {
+		return allocator_;
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return iterator{this, 0};
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return const_iterator{this, 0};
+	}
+
+	auto end() noexcept -> iterator {
+		return iterator{this, size()};
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return const_iterator{this, size()};
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size() == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return capacity_ - gap_size();
+	}
+
+	auto max_size() const noexcept -> size_type {
+		return std::allocator_traits<Allocator>::max_size(allocator_);
+	}
+
+	auto capacity() const noexcept -> size_type {
+		return capacity_;
+	}
+
+	// Index of the first slot of the gap, i.e. where the next insertion is cheapest.
+	auto gap_position() const noexcept -> size_type {
+		return gap_begin_;
+	}
+
+	auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > max_size())
+			throw std::length_error{"gap_vector::reserve : new_capacity > max_size()"};
+
+		if(new_capacity > capacity()) {
+			auto previous_data = data_;
+			auto previous_capacity = capacity_;
+			auto back_size = capacity_ - gap_end_;
+
+			data_ = std::allocator_traits<Allocator>::allocate(allocator_, new_capacity);
+			capacity_ = new_capacity;
+
+			for(auto i = size_type{0}; i < gap_begin_; ++i)
+				relocate(previous_data + i, data_ + i);
+			for(auto i = size_type{0}; i < back_size; ++i)
+				relocate(
+					previous_data + previous_capacity - back_size + i,
+					data_ + new_capacity - back_size + i);
+			gap_end_ = new_capacity - back_size;
+
+			std::allocator_traits<Allocator>::deallocate(allocator_, previous_data, previous_capacity);
+		}
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return *slot(index);
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		auto mutable_this = const_cast<gap_vector*>(this);
+		return mutable_this->operator[](index);
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("gap_vector::at : index >= size()");
+		return operator[](index);
+	}
+
+	auto at(size_type index) const -> const_reference {
+		auto mutable_this = const_cast<gap_vector*>(this);
+		return mutable_this->at(index);
+	}
+
+	auto front() -> reference {
+		return operator[](0);
+	}
+
+	auto front() const -> const_reference {
+		return operator[](0);
+	}
+
+	auto back() -> reference {
+		return operator[](size() - 1);
+	}
+
+	auto back() const -> const_reference {
+		return operator[](size() - 1);
+	}
+
+	// modifiers
+
+	template<class... Args>
+	auto emplace(const_iterator position, Args&&... args) -> iterator {
+		auto index = position.index();
+		// Built first, as args may refer to an element about to move.
+		auto to_emplace = Value(std::forward<Args>(args)...);
+		if(gap_size() == 0)
+			reserve(2 * capacity() + 1);
+		move_gap(index);
+		std::allocator_traits<Allocator>::construct(
+			allocator_, data_ + gap_begin_, std::move(to_emplace));
+		gap_begin_ += 1;
+		return iterator{this, index};
+	}
+
+	auto insert(const_iterator position, const Value& to_insert) -> iterator {
+		return emplace(position, to_insert);
+	}
+
+	auto insert(const_iterator position, Value&& to_insert) -> iterator {
+		return emplace(position, std::move(to_insert));
+	}
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		return *emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	auto pop_back() -> void {
+		erase(cend() - 1);
+	}
+
+	auto erase(const_iterator position) -> iterator {
+		return erase(position, position + 1);
+	}
+
+	auto erase(const_iterator first, const_iterator last) -> iterator {
+		move_gap(first.index());
+		for(auto count = last - first; count > 0; --count) {
+			std::allocator_traits<Allocator>::destroy(allocator_, data_ + gap_end_);
+			gap_end_ += 1;
+		}
+		return iterator{this, first.index()};
+	}
+
+	auto swap(gap_vector& to_swap) noexcept -> void {
+		std::swap(capacity_, to_swap.capacity_);
+		std::swap(gap_begin_, to_swap.gap_begin_);
+		std::swap(gap_end_, to_swap.gap_end_);
+		std::swap(allocator_, to_swap.allocator_);
+		std::swap(data_, to_swap.data_);
+	}
+
+	auto clear() noexcept -> void {
+		for(auto i = size_type{0}; i < gap_begin_; ++i)
+			std::allocator_traits<Allocator>::destroy(allocator_, data_ + i);
+		for(auto i = gap_end_; i < capacity_; ++i)
+			std::allocator_traits<Allocator>::destroy(allocator_, data_ + i);
+		gap_begin_ = 0;
+		gap_end_ = capacity_;
+	}
+
+private:
+
+	auto gap_size() const noexcept -> size_type {
+		return gap_end_ - gap_begin_;
+	}
+
+	auto slot(size_type index) noexcept -> Value* {
+		return data_ + (index < gap_begin_ ? index : index + gap_size());
+	}
+
+	auto relocate(Value* from, Value* to) -> void {
+		std::allocator_traits<Allocator>::construct(allocator_, to, std::move(*from));
+		std::allocator_traits<Allocator>::destroy(allocator_, from);
+	}
+
+	auto move_gap(size_type position) -> void {
+		while(position < gap_begin_) {
+			gap_begin_ -= 1;
+			gap_end_ -= 1;
+			relocate(data_ + gap_begin_, data_ + gap_end_);
+		}
+		while(position > gap_begin_) {
+			relocate(data_ + gap_end_, data_ + gap_begin_);
+			gap_begin_ += 1;
+			gap_end_ += 1;
+		}
+	}
+
+	size_type capacity_;
+	size_type gap_begin_;
+	size_type gap_end_;
+
+	Allocator allocator_;
+	Value* data_;
+};
+
+template<class Value, class Allocator>
+void swap(gap_vector<Value, Allocator>& x, gap_vector<Value, Allocator>& y)
+noexcept(noexcept(x.swap(y))) {
+	x.swap(y);
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#include<algorithm>
+#include<cstddef>
+#include<iterator>
+#include<memory>
+#include<stdexcept>
+
+#include "indexed_iterator.hpp"
+
+// Growable array that spreads reallocation over later appends, like
+// incremental rehashing : when push_back finds the buffer full it allocates a
+// new one, and each following push_back relocates at most MigrationStep
+// elements from the old buffer. Until migration finishes, elements
+// [migrated_, old_size_) are still read from the old buffer.
+// With geometric growth and MigrationStep >= 1 the migration always ends
+// before the new buffer is full, so no push_back relocates more than
+// MigrationStep elements.
+
+template<class Value, class Allocator = std::allocator<Value>, std::size_t MigrationStep = 8>
+class incremental_vector {
+	static_assert(MigrationStep >= 1, "incremental_vector : MigrationStep must be at least 1");
+
+public:
+
+	// types
+
+	using value_type = Value;
+	using allocator_type = Allocator;
+	using pointer = typename std::allocator_traits<Allocator>::pointer;
+	using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = typename std::allocator_traits<Allocator>::size_type;
+	using difference_type = typename std::allocator_traits<Allocator>::difference_type;
+	using iterator = indexed_iterator<incremental_vector, false>;
+	using const_iterator = indexed_iterator<incremental_vector, true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	incremental_vector() noexcept(noexcept(Allocator()))
+		: incremental_vector(Allocator())
+	{}
+
+	explicit
+	incremental_vector(const Allocator& with_allocator) noexcept
+		: capacity_{0}
+		, size_{0}
+		, old_capacity_{0}
+		, old_size_{0}
+		, migrated_{0}
+
+		, allocator_{with_allocator}
+		, data_{nullptr}
+		, old_data_{nullptr}
+	{}
+
+	incremental_vector(const incremental_vector& from_vector)
+		: incremental_vector(
+			std::allocator_traits<Allocator>::select_on_container_copy_construction(
+				from_vector.allocator_))
+	{
+		reserve(from_vector.size());
+		for(auto& value : from_vector)
+			push_back(value);
+	}
+
+	incremental_vector(incremental_vector&& from_vector) noexcept
+		: capacity_{from_vector.capacity_}
+		, size_{from_vector.size_}
+		, old_capacity_{from_vector.old_capacity_}
+		, old_size_{from_vector.old_size_}
+		, migrated_{from_vector.migrated_}
+
+		, allocator_{from_vector.allocator_}
+		, data_{from_vector.data_}
+		, old_data_{from_vector.old_data_}
+	{
+		from_vector.capacity_ = 0;
+		from_vector.size_ = 0;
+		from_vector.old_capacity_ = 0;
+		from_vector.old_size_ = 0;
+		from_vector.migrated_ = 0;
+		from_vector.data_ = nullptr;
+		from_vector.old_data_ = nullptr;
+	}
+
+	~incremental_vector() {
+		clear();
+		std::allocator_traits<Allocator>::deallocate(allocator_, data_, capacity_);
+	}
+
+	auto operator=(incremental_vector from_vector) noexcept -> incremental_vector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	auto get_allocator() const noexcept -> allocator_type {
+		return allocator_;
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return iterator{this, 0};
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return const_iterator{this, 0};
+	}
+
+	auto end() noexcept -> iterator {
+		return iterator{this, size()};
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return const_iterator{this, size()};
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size_ == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return size_;
+	}
+
+	auto max_size() const noexcept -> size_type {
+		return std::allocator_traits<Allocator>::max_size(allocator_);
+	}
+
+	auto capacity() const noexcept -> size_type {
+		return capacity_;
+	}
+
+	auto migrating() const noexcept -> bool {
+		return old_data_ != nullptr;
+	}
+
+	// Relocates every element still in the old buffer, in one go.
+	auto finish_migration() -> void {
+		while(migrating())
+			migrate(old_size_);
+	}
+
+	// Unlike push_back, an explicit reserve relocates everything immediately.
+	auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > max_size())
+			throw std::length_error{"incremental_vector::reserve : new_capacity > max_size()"};
+
+		if(new_capacity > capacity()) {
+			finish_migration();
+			start_migration(new_capacity);
+			finish_migration();
+		}
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return *slot(index);
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		auto mutable_this = const_cast<incremental_vector*>(this);
+		return mutable_this->operator[](index);
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("incremental_vector::at : index >= size()");
+		return operator[](index);
+	}
+
+	auto at(size_type index) const -> const_reference {
+		auto mutable_this = const_cast<incremental_vector*>(this);
+		return mutable_this->at(index);
+	}
+
+	auto front() -> reference {
+		return operator[](0);
+	}
+
+	auto front() const -> const_reference {
+		return operator[](0);
+	}
+
+	auto back() -> reference {
+		return operator[](size() - 1);
+	}
+
+	auto back() const -> const_reference {
+		return operator[](size() - 1);
+	}
+
+	// Contiguous storage, which exists only once migration is finished.
+	auto data() -> Value* {
+		finish_migration();
+		return data_;
+	}
+
+	// modifiers
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		if(size() == capacity()) {
+			finish_migration();
+			start_migration(2 * capacity() + 1);
+		}
+		std::allocator_traits<Allocator>::construct(allocator_, data_ + size_, std::forward<Args>(args)...);
+		size_ += 1;
+		if(migrating())
+			migrate(MigrationStep);
+		return back();
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	auto pop_back() -> void {
+		std::allocator_traits<Allocator>::destroy(allocator_, slot(size_ - 1));
+		size_ -= 1;
+		if(migrating() && size_ < old_size_) {
+			old_size_ = size_;
+			migrate(0);
+		}
+	}
+
+	auto swap(incremental_vector& to_swap) noexcept -> void {
+		std::swap(capacity_, to_swap.capacity_);
+		std::swap(size_, to_swap.size_);
+		std::swap(old_capacity_, to_swap.old_capacity_);
+		std::swap(old_size_, to_swap.old_size_);
+		std::swap(migrated_, to_swap.migrated_);
+		std::swap(allocator_, to_swap.allocator_);
+		std::swap(data_, to_swap.data_);
+		std::swap(old_data_, to_swap.old_data_);
+	}
+
+	auto clear() noexcept -> void {
+		for(auto i = size_type{0}; i < size_; ++i)
+			std::allocator_traits<Allocator>::destroy(allocator_, slot(i));
+		size_ = 0;
+		if(migrating()) {
+			old_size_ = 0;
+			migrate(0);
+		}
+	}
+
+private:
+
+	auto slot(size_type index) noexcept -> Value* {
+		if(index >= migrated_ && index < old_size_)
+			return old_data_ + index;
+		return data_ + index;
+	}
+
+	auto start_migration(size_type new_capacity) -> void {
+		auto new_data = std::allocator_traits<Allocator>::allocate(allocator_, new_capacity);
+
+		old_data_ = data_;
+		old_capacity_ = capacity_;
+		old_size_ = size_;
+		migrated_ = 0;
+
+		data_ = new_data;
+		capacity_ = new_capacity;
+
+		if(old_size_ == 0)
+			end_migration();
+	}
+
+	// Relocates up to count elements, and frees the old buffer once it is empty.
+	auto migrate(size_type count) -> void {
+		auto last = std::min(old_size_, migrated_ + count);
+		for(; migrated_ < last; ++migrated_) {
+			std::allocator_traits<Allocator>::construct(allocator_, data_ + migrated_, std::move(old_data_[migrated_]));
+			std::allocator_traits<Allocator>::destroy(allocator_, old_data_ + migrated_);
+		}
+		if(migrated_ >= old_size_)
+			end_migration();
+	}
+
+	auto end_migration() -> void {
+		std::allocator_traits<Allocator>::deallocate(allocator_, old_data_, old_capacity_);
+		old_data_ = nullptr;
+		old_capacity_ = 0;
+		old_size_ = 0;
+		migrated_ = 0;
+	}
+
+	size_type capacity_;
+	size_type size_;
+	size_type old_capacity_;
+	size_type old_size_;
+	size_type migrated_;
+
+	Allocator allocator_;
+	Value* data_;
+	Value* old_data_;
+};
+
+template<class Value, class Allocator, std::size_t MigrationStep>
+void swap(
+	incremental_vector<Value, Allocator, MigrationStep>& x,
+	incremental_vector<Value, Allocator, MigrationStep>& y
+) noexcept(noexcept(x.swap(y))) {
+	x.swap(y);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include<cstddef>
+#include<iterator>
+#include<type_traits>
+
+// Random access iterator holding a container and an index, dereferenced
+// through Container::operator[], for containers whose storage is not one
+// contiguous array.
+
+template<class Container, bool Const>
+class indexed_iterator {
+	using container_pointer = std::conditional_t<Const, const Container*, Container*>;
+
+public:
+
+	using iterator_category = std::random_access_iterator_tag;
+	using value_type = typename Container::value_type;
+	using difference_type = typename Container::difference_type;
+	using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+	using reference = std::conditional_t<Const, typename Container::const_reference, typename Container::reference>;
+	using size_type = typename Container::size_type;
+
+	indexed_iterator() noexcept
+		: container_{nullptr}
+		, index_{0}
+	{}
+
+	indexed_iterator(container_pointer with_container, size_type with_index) noexcept
+		: container_{with_container}
+		, index_{with_index}
+	{}
+
+	operator indexed_iterator<Container, true>() const noexcept {
+		return {container_, index_};
+	}
+
+	auto index() const noexcept -> size_type {
+		return index_;
+	}
+
+	auto operator*() const -> reference {
+		return (*container_)[index_];
+	}
+
+	auto operator->() const -> pointer {
+		return &(*container_)[index_];
+	}
+
+	auto operator[](difference_type offset) const -> reference {
+		return (*container_)[index_ + offset];
+	}
+
+	auto operator++() noexcept -> indexed_iterator& {
+		index_ += 1;
+		return *this;
+	}
+
+	auto operator++(int) noexcept -> indexed_iterator {
+		auto previous = *this;
+		index_ += 1;
+		return previous;
+	}
+
+	auto operator--() noexcept -> indexed_iterator& {
+		index_ -= 1;
+		return *this;
+	}
+
+	auto operator--(int) noexcept -> indexed_iterator {
+		auto previous = *this;
+		index_ -= 1;
+		return previous;
+	}
+
+	auto operator+=(difference_type offset) noexcept -> indexed_iterator& {
+		index_ += offset;
+		return *this;
+	}
+
+	auto operator-=(difference_type offset) noexcept -> indexed_iterator& {
+		index_ -= offset;
+		return *this;
+	}
+
+	friend auto operator+(indexed_iterator it, difference_type offset) noexcept -> indexed_iterator {
+		return it += offset;
+	}
+
+	friend auto operator+(difference_type offset, indexed_iterator it) noexcept -> indexed_iterator {
+		return it += offset;
+	}
+
+	friend auto operator-(indexed_iterator it, difference_type offset) noexcept -> indexed_iterator {
+		return it -= offset;
+	}
+
+	friend auto operator-(const indexed_iterator& x, const indexed_iterator& y) noexcept -> difference_type {
+		return static_cast<difference_type>(x.index_) - static_cast<difference_type>(y.index_);
+	}
+
+	friend auto operator==(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ == y.index_;
+	}
+
+	friend auto operator!=(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ != y.index_;
+	}
+
+	friend auto operator<(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ < y.index_;
+	}
+
+	friend auto operator>(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ > y.index_;
+	}
+
+	friend auto operator<=(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ <= y.index_;
+	}
+
+	friend auto operator>=(const indexed_iterator& x, const indexed_iterator& y) noexcept -> bool {
+		return x.index_ >= y.index_;
+	}
+
+private:
+
+	container_pointer container_;
+	size_type index_;
+};
@@ -0,0 +1,439 @@
+#pragma once
+
+#include<cstddef>
+#include<initializer_list>
+#include<iterator>
+#include<new>
+#include<stdexcept>
+#include<type_traits>
+#include<utility>
+
+// Vector with a fixed Capacity stored inside the object, never touching the
+// heap. For trivial Values the elements are a plain array, which makes the
+// whole container usable in constant expressions.
+
+namespace inplace_vector_detail {
+
+	template<class Value, class... Args>
+	constexpr auto make(Args&&... args) -> Value {
+		if constexpr(std::is_constructible_v<Value, Args...>)
+			return Value(std::forward<Args>(args)...);
+		else
+			return Value{std::forward<Args>(args)...};
+	}
+
+	template<class Value, std::size_t Capacity, bool = std::is_trivial_v<Value>>
+	struct storage {
+		constexpr storage() noexcept
+			: size_{0}
+			, values_{}
+		{}
+
+		constexpr auto data() noexcept -> Value* {
+			return values_;
+		}
+
+		constexpr auto data() const noexcept -> const Value* {
+			return values_;
+		}
+
+		template<class... Args>
+		constexpr auto construct(std::size_t index, Args&&... args) -> void {
+			values_[index] = make<Value>(std::forward<Args>(args)...);
+		}
+
+		constexpr auto destroy(std::size_t) noexcept -> void {}
+
+		std::size_t size_;
+		Value values_[Capacity];
+	};
+
+	template<class Value, std::size_t Capacity>
+	struct storage<Value, Capacity, false> {
+		storage() noexcept
+			: size_{0}
+		{}
+
+		storage(const storage& from_storage)
+			: size_{0}
+		{
+			for(; size_ < from_storage.size_; ++size_)
+				construct(size_, from_storage.data()[size_]);
+		}
+
+		storage(storage&& from_storage) noexcept(std::is_nothrow_move_constructible_v<Value>)
+			: size_{0}
+		{
+			for(; size_ < from_storage.size_; ++size_)
+				construct(size_, std::move(from_storage.data()[size_]));
+		}
+
+		auto operator=(const storage& from_storage) -> storage& {
+			if(this != &from_storage)
+				assign(from_storage.data(), from_storage.size_);
+			return *this;
+		}
+
+		auto operator=(storage&& from_storage) noexcept(std::is_nothrow_move_assignable_v<Value>) -> storage& {
+			if(this != &from_storage)
+				assign(std::make_move_iterator(from_storage.data()), from_storage.size_);
+			return *this;
+		}
+
+		~storage() {
+			for(auto index = std::size_t{0}; index < size_; ++index)
+				destroy(index);
+		}
+
+		auto data() noexcept -> Value* {
+			return std::launder(reinterpret_cast<Value*>(bytes_));
+		}
+
+		auto data() const noexcept -> const Value* {
+			return std::launder(reinterpret_cast<const Value*>(bytes_));
+		}
+
+		template<class... Args>
+		auto construct(std::size_t index, Args&&... args) -> void {
+			::new(static_cast<void*>(bytes_ + index * sizeof(Value))) Value(std::forward<Args>(args)...);
+		}
+
+		auto destroy(std::size_t index) noexcept -> void {
+			data()[index].~Value();
+		}
+
+		template<class Iterator>
+		auto assign(Iterator from, std::size_t count) -> void {
+			auto index = std::size_t{0};
+			for(; index < count && index < size_; ++index, ++from)
+				data()[index] = *from;
+			for(; index < count; ++index, ++from) {
+				construct(index, *from);
+				size_ = index + 1;
+			}
+			for(; size_ > count; --size_)
+				destroy(size_ - 1);
+		}
+
+		std::size_t size_;
+		alignas(Value) unsigned char bytes_[Capacity * sizeof(Value)];
+	};
+}
+
+template<class Value, std::size_t Capacity>
+class inplace_vector {
+	static_assert(Capacity > 0, "inplace_vector : Capacity must not be 0");
+
+public:
+
+	// types
+
+	using value_type = Value;
+	using pointer = Value*;
+	using const_pointer = const Value*;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using iterator = Value*;
+	using const_iterator = const Value*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	inplace_vector() noexcept = default;
+
+	constexpr explicit
+	inplace_vector(size_type with_size) {
+		resize(with_size);
+	}
+
+	constexpr inplace_vector(size_type with_size, const Value& with_value) {
+		resize(with_size, with_value);
+	}
+
+	constexpr inplace_vector(std::initializer_list<Value> values) {
+		assign(values);
+	}
+
+	template<
+		class InputIterator,
+		class = typename std::iterator_traits<InputIterator>::iterator_category>
+	constexpr inplace_vector(InputIterator first, InputIterator last) {
+		assign(first, last);
+	}
+
+	template<
+		class InputIterator,
+		class = typename std::iterator_traits<InputIterator>::iterator_category>
+	constexpr auto assign(InputIterator first, InputIterator last) -> void {
+		clear();
+		for(; first != last; ++first)
+			emplace_back(*first);
+	}
+
+	constexpr auto assign(size_type n, const Value& u) -> void {
+		clear();
+		resize(n, u);
+	}
+
+	constexpr auto assign(std::initializer_list<Value> values) -> void {
+		assign(values.begin(), values.end());
+	}
+
+	// iterators
+
+	constexpr auto begin() noexcept -> iterator {
+		return data();
+	}
+
+	constexpr auto begin() const noexcept -> const_iterator {
+		return data();
+	}
+
+	constexpr auto end() noexcept -> iterator {
+		return data() + size();
+	}
+
+	constexpr auto end() const noexcept -> const_iterator {
+		return data() + size();
+	}
+
+	constexpr auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	constexpr auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	constexpr auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	constexpr auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	constexpr auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	constexpr auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	constexpr auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	constexpr auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	constexpr auto empty() const noexcept -> bool {
+		return size() == 0;
+	}
+
+	constexpr auto size() const noexcept -> size_type {
+		return storage_.size_;
+	}
+
+	static constexpr auto max_size() noexcept -> size_type {
+		return Capacity;
+	}
+
+	static constexpr auto capacity() noexcept -> size_type {
+		return Capacity;
+	}
+
+	constexpr auto resize(size_type new_size) -> void {
+		if(new_size > capacity())
+			throw std::bad_alloc{};
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back();
+	}
+
+	constexpr auto resize(size_type new_size, const Value& to_copy) -> void {
+		if(new_size > capacity())
+			throw std::bad_alloc{};
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back(to_copy);
+	}
+
+	static constexpr auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > capacity())
+			throw std::bad_alloc{};
+	}
+
+	static constexpr auto shrink_to_fit() noexcept -> void {}
+
+	// element access
+
+	constexpr auto operator[](size_type index) -> reference {
+		return data()[index];
+	}
+
+	constexpr auto operator[](size_type index) const -> const_reference {
+		return data()[index];
+	}
+
+	constexpr auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("inplace_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	constexpr auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("inplace_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	constexpr auto front() -> reference {
+		return data()[0];
+	}
+
+	constexpr auto front() const -> const_reference {
+		return data()[0];
+	}
+
+	constexpr auto back() -> reference {
+		return data()[size() - 1];
+	}
+
+	constexpr auto back() const -> const_reference {
+		return data()[size() - 1];
+	}
+
+	// data access
+
+	constexpr auto data() noexcept -> Value* {
+		return storage_.data();
+	}
+
+	constexpr auto data() const noexcept -> const Value* {
+		return storage_.data();
+	}
+
+	// modifiers
+
+	// Throws std::bad_alloc when the vector is full.
+	template<class... Args>
+	constexpr auto emplace_back(Args&&... args) -> reference {
+		if(size() == capacity())
+			throw std::bad_alloc{};
+		storage_.construct(size(), std::forward<Args>(args)...);
+		storage_.size_ += 1;
+		return back();
+	}
+
+	constexpr auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	constexpr auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	template<class... Args>
+	constexpr auto try_emplace_back(Args&&... args)
+	noexcept(std::is_nothrow_constructible_v<Value, Args...>) -> bool {
+		if(size() == capacity())
+			return false;
+		storage_.construct(size(), std::forward<Args>(args)...);
+		storage_.size_ += 1;
+		return true;
+	}
+
+	constexpr auto try_push_back(const Value& to_push)
+	noexcept(std::is_nothrow_copy_constructible_v<Value>) -> bool {
+		return try_emplace_back(to_push);
+	}
+
+	constexpr auto try_push_back(Value&& to_push)
+	noexcept(std::is_nothrow_move_constructible_v<Value>) -> bool {
+		return try_emplace_back(std::move(to_push));
+	}
+
+	constexpr auto pop_back() -> void {
+		storage_.size_ -= 1;
+		storage_.destroy(size());
+	}
+
+	template<class... Args>
+	constexpr auto emplace(const_iterator position, Args&&... args) -> iterator {
+		auto index = static_cast<size_type>(position - cbegin());
+		if(index == size()) {
+			emplace_back(std::forward<Args>(args)...);
+			return begin() + index;
+		}
+		auto to_emplace = inplace_vector_detail::make<Value>(std::forward<Args>(args)...);
+		emplace_back(std::move(back()));
+		for(auto i = size() - 2; i > index; --i)
+			data()[i] = std::move(data()[i - 1]);
+		data()[index] = std::move(to_emplace);
+		return begin() + index;
+	}
+
+	constexpr auto insert(const_iterator position, const Value& to_insert) -> iterator {
+		return emplace(position, to_insert);
+	}
+
+	constexpr auto insert(const_iterator position, Value&& to_insert) -> iterator {
+		return emplace(position, std::move(to_insert));
+	}
+
+	constexpr auto erase(const_iterator position) -> iterator {
+		return erase(position, position + 1);
+	}
+
+	constexpr auto erase(const_iterator first, const_iterator last) -> iterator {
+		auto index = static_cast<size_type>(first - cbegin());
+		auto count = static_cast<size_type>(last - first);
+		for(auto i = index; i + count < size(); ++i)
+			data()[i] = std::move(data()[i + count]);
+		for(; count > 0; --count)
+			pop_back();
+		return begin() + index;
+	}
+
+	constexpr auto swap(inplace_vector& to_swap)
+	noexcept(std::is_nothrow_swappable_v<Value> && std::is_nothrow_move_constructible_v<Value>) -> void {
+		auto& shorter = size() < to_swap.size() ? *this : to_swap;
+		auto& longer = size() < to_swap.size() ? to_swap : *this;
+		auto common = shorter.size();
+		for(auto i = size_type{0}; i < common; ++i) {
+			auto temporary = std::move(shorter[i]);
+			shorter[i] = std::move(longer[i]);
+			longer[i] = std::move(temporary);
+		}
+		for(auto i = common; i < longer.size(); ++i)
+			shorter.emplace_back(std::move(longer[i]));
+		while(longer.size() > common)
+			longer.pop_back();
+	}
+
+	constexpr auto clear() noexcept -> void {
+		while(!empty())
+			pop_back();
+	}
+
+private:
+
+	inplace_vector_detail::storage<Value, Capacity> storage_;
+};
+
+template<class Value, std::size_t Capacity>
+constexpr auto swap(inplace_vector<Value, Capacity>& x, inplace_vector<Value, Capacity>& y)
+noexcept(noexcept(x.swap(y))) -> void {
+	x.swap(y);
+}
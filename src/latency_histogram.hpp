@@ -0,0 +1,92 @@
+#pragma once
+
+#include<array>
+#include<cstddef>
+#include<cstdint>
+
+// Log-linear histogram in the style of HdrHistogram : values below 2^Precision
+// are counted exactly, larger ones in 2^(Precision - 1) buckets per power of
+// two, so the relative error stays under 2^(1 - Precision).
+
+template<unsigned Precision = 7>
+class latency_histogram {
+public:
+
+	latency_histogram() noexcept
+		: counts_{}
+		, count_{0}
+		, max_{0}
+	{}
+
+	auto record(std::uint64_t value) noexcept -> void {
+		counts_[bucket_of(value)] += 1;
+		count_ += 1;
+		if(value > max_)
+			max_ = value;
+	}
+
+	auto count() const noexcept -> std::uint64_t {
+		return count_;
+	}
+
+	auto max() const noexcept -> std::uint64_t {
+		return max_;
+	}
+
+	// Smallest recorded value v such that a fraction q of the values are <= v,
+	// rounded to the midpoint of its bucket.
+	auto percentile(double q) const noexcept -> std::uint64_t {
+		if(count_ == 0)
+			return 0;
+		auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+		if(rank >= count_)
+			return max_;
+		auto seen = std::uint64_t{0};
+		for(auto bucket = std::size_t{0}; bucket < bucket_count; ++bucket) {
+			seen += counts_[bucket];
+			if(seen >= rank) {
+				auto midpoint = lowest_of(bucket) + width_of(bucket) / 2;
+				return midpoint < max_ ? midpoint : max_;
+			}
+		}
+		return max_;
+	}
+
+private:
+
+	static constexpr auto linear_count = std::uint64_t{1} << Precision;
+	static constexpr auto half_count = linear_count / 2;
+	static constexpr auto bucket_count = linear_count + (64 - Precision) * half_count;
+
+	static auto magnitude_of(std::uint64_t value) noexcept -> unsigned {
+		auto magnitude = 0u;
+		while((value >> magnitude) >= linear_count)
+			magnitude += 1;
+		return magnitude;
+	}
+
+	static auto bucket_of(std::uint64_t value) noexcept -> std::size_t {
+		if(value < linear_count)
+			return value;
+		auto magnitude = magnitude_of(value);
+		return linear_count + (magnitude - 1) * half_count + ((value >> magnitude) - half_count);
+	}
+
+	static auto lowest_of(std::size_t bucket) noexcept -> std::uint64_t {
+		if(bucket < linear_count)
+			return bucket;
+		auto magnitude = (bucket - linear_count) / half_count + 1;
+		auto sub_bucket = (bucket - linear_count) % half_count + half_count;
+		return sub_bucket << magnitude;
+	}
+
+	static auto width_of(std::size_t bucket) noexcept -> std::uint64_t {
+		if(bucket < linear_count)
+			return 1;
+		return std::uint64_t{1} << ((bucket - linear_count) / half_count + 1);
+	}
+
+	std::array<std::uint64_t, bucket_count> counts_;
+	std::uint64_t count_;
+	std::uint64_t max_;
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include<cerrno>
+#include<cstddef>
+#include<iterator>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<utility>
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include "vector_file.hpp"
+
+// Read-only view of a file in the vector_file layout, mapped shared so every
+// process reading the same file uses the same page cache pages. Nothing is
+// copied or parsed besides the header : elements are read in place.
+
+enum class mapped_access {
+	normal,
+	sequential,
+	random,
+};
+
+template<class Value>
+class mapped_view {
+public:
+
+	// types
+
+	using value_type = Value;
+	using pointer = const Value*;
+	using const_pointer = const Value*;
+	using reference = const value_type&;
+	using const_reference = const value_type&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using iterator = const Value*;
+	using const_iterator = const Value*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	// With populate, the whole file is read ahead when mapping (MAP_POPULATE
+	// where available) instead of page by page on first access.
+	explicit
+	mapped_view(const char* path, mapped_access access = mapped_access::normal, [[maybe_unused]] bool populate = false)
+		: mapping_{nullptr}
+		, mapped_bytes_{0}
+		, size_{0}
+	{
+		auto descriptor = ::open(path, O_RDONLY | O_CLOEXEC);
+		if(descriptor < 0)
+			throw_errno("open");
+		struct stat status;
+		if(::fstat(descriptor, &status) != 0) {
+			auto error = errno;
+			::close(descriptor);
+			errno = error;
+			throw_errno("fstat");
+		}
+		mapped_bytes_ = static_cast<std::size_t>(status.st_size);
+		if(mapped_bytes_ < data_offset) {
+			::close(descriptor);
+			throw std::runtime_error{"mapped_view : file too short"};
+		}
+
+		auto flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+		if(populate)
+			flags |= MAP_POPULATE;
+#endif
+		auto mapping = ::mmap(nullptr, mapped_bytes_, PROT_READ, flags, descriptor, 0);
+		auto error = errno;
+		::close(descriptor);
+		if(mapping == MAP_FAILED) {
+			errno = error;
+			throw_errno("mmap");
+		}
+		mapping_ = mapping;
+
+		try {
+			auto& header = *static_cast<const vector_file_header*>(mapping_);
+			check_vector_file_header<Value>(header);
+			if(header.count > (mapped_bytes_ - data_offset) / sizeof(Value))
+				throw std::runtime_error{"mapped_view : file too short"};
+			size_ = static_cast<size_type>(header.count);
+			advise(access);
+		}
+		catch(...) {
+			::munmap(mapping_, mapped_bytes_);
+			throw;
+		}
+	}
+
+	mapped_view(const mapped_view&) = delete;
+
+	mapped_view(mapped_view&& from_view) noexcept
+		: mapping_{from_view.mapping_}
+		, mapped_bytes_{from_view.mapped_bytes_}
+		, size_{from_view.size_}
+	{
+		from_view.mapping_ = nullptr;
+		from_view.mapped_bytes_ = 0;
+		from_view.size_ = 0;
+	}
+
+	~mapped_view() {
+		if(mapping_ != nullptr)
+			::munmap(mapping_, mapped_bytes_);
+	}
+
+	auto operator=(mapped_view from_view) noexcept -> mapped_view& {
+		swap(from_view);
+		return *this;
+	}
+
+	// Tells the kernel how the elements will be read, for its read-ahead.
+	auto advise(mapped_access access) const -> void {
+		auto advice = MADV_NORMAL;
+		if(access == mapped_access::sequential)
+			advice = MADV_SEQUENTIAL;
+		else if(access == mapped_access::random)
+			advice = MADV_RANDOM;
+		if(::madvise(mapping_, mapped_bytes_, advice) != 0)
+			throw_errno("madvise");
+	}
+
+	// iterators
+
+	auto begin() const noexcept -> const_iterator {
+		return data();
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return data() + size();
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size_ == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return size_;
+	}
+
+	// element access
+
+	auto operator[](size_type index) const -> const_reference {
+		return data()[index];
+	}
+
+	auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("mapped_view::at : index >= size()");
+		return data()[index];
+	}
+
+	auto front() const -> const_reference {
+		return data()[0];
+	}
+
+	auto back() const -> const_reference {
+		return data()[size() - 1];
+	}
+
+	// data access
+
+	auto data() const noexcept -> const Value* {
+		return reinterpret_cast<const Value*>(static_cast<const char*>(mapping_) + data_offset);
+	}
+
+	// modifiers
+
+	auto swap(mapped_view& to_swap) noexcept -> void {
+		std::swap(mapping_, to_swap.mapping_);
+		std::swap(mapped_bytes_, to_swap.mapped_bytes_);
+		std::swap(size_, to_swap.size_);
+	}
+
+private:
+
+	static constexpr std::size_t data_offset = vector_file_data_offset<Value>();
+
+	[[noreturn]]
+	static auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"mapped_view : "} + call};
+	}
+
+	void* mapping_;
+	std::size_t mapped_bytes_;
+	size_type size_;
+};
+
+template<class Value>
+void swap(mapped_view<Value>& x, mapped_view<Value>& y) noexcept {
+	x.swap(y);
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include<cerrno>
+#include<cstddef>
+#include<iterator>
+#include<new>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<type_traits>
+#include<utility>
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include "vector_file.hpp"
+
+// Vector of trivially copyable values kept in a shared mapping of a file in
+// the vector_file layout. The size lives in the mapped header, so the file is
+// always up to date as far as the page cache goes, and opening it again maps
+// it without reading the elements. Growth extends the file with ftruncate and
+// the mapping with mremap; flush() makes the contents durable.
+
+template<class Value>
+class mmap_vector {
+	static_assert(std::is_trivially_copyable_v<Value>, "mmap_vector : Value must be trivially copyable");
+
+public:
+
+	// types
+
+	using value_type = Value;
+	using pointer = Value*;
+	using const_pointer = const Value*;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using iterator = Value*;
+	using const_iterator = const Value*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	// Opens the vector stored at path, or creates an empty one there.
+	explicit
+	mmap_vector(const char* path)
+		: descriptor_{::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)}
+		, mapping_{nullptr}
+		, mapped_bytes_{0}
+	{
+		if(descriptor_ < 0)
+			throw_errno("open");
+		try {
+			struct stat status;
+			if(::fstat(descriptor_, &status) != 0)
+				throw_errno("fstat");
+			auto file_bytes = static_cast<std::size_t>(status.st_size);
+			if(file_bytes == 0) {
+				remap(data_offset);
+				*header() = make_vector_file_header<Value>(0);
+			}
+			else {
+				if(file_bytes < data_offset)
+					throw std::runtime_error{"mmap_vector : file too short"};
+				map(file_bytes);
+				check_vector_file_header<Value>(*header());
+				if(size() > capacity())
+					throw std::runtime_error{"mmap_vector : file too short"};
+			}
+		}
+		catch(...) {
+			close();
+			throw;
+		}
+	}
+
+	mmap_vector(const mmap_vector&) = delete;
+
+	mmap_vector(mmap_vector&& from_vector) noexcept
+		: descriptor_{from_vector.descriptor_}
+		, mapping_{from_vector.mapping_}
+		, mapped_bytes_{from_vector.mapped_bytes_}
+	{
+		from_vector.descriptor_ = -1;
+		from_vector.mapping_ = nullptr;
+		from_vector.mapped_bytes_ = 0;
+	}
+
+	~mmap_vector() {
+		close();
+	}
+
+	auto operator=(mmap_vector from_vector) noexcept -> mmap_vector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return data();
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return data();
+	}
+
+	auto end() noexcept -> iterator {
+		return data() + size();
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return data() + size();
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size() == 0;
+	}
+
+	// A moved-from mmap_vector maps nothing, and is empty.
+	auto size() const noexcept -> size_type {
+		if(mapping_ == nullptr)
+			return 0;
+		return static_cast<size_type>(header()->count);
+	}
+
+	auto capacity() const noexcept -> size_type {
+		if(mapping_ == nullptr)
+			return 0;
+		return (mapped_bytes_ - data_offset) / sizeof(Value);
+	}
+
+	auto resize(size_type new_size) -> void {
+		resize(new_size, Value{});
+	}
+
+	auto resize(size_type new_size, const Value& to_copy) -> void {
+		reserve(new_size);
+		for(auto i = size(); i < new_size; ++i)
+			::new(static_cast<void*>(data() + i)) Value(to_copy);
+		header()->count = new_size;
+	}
+
+	// Extends the file, and the mapping with it, to new_capacity elements.
+	auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > capacity())
+			remap(data_offset + new_capacity * sizeof(Value));
+	}
+
+	// Truncates the file after the last element.
+	auto shrink_to_fit() -> void {
+		if(capacity() > size())
+			remap(data_offset + size() * sizeof(Value));
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return data()[index];
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		return data()[index];
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("mmap_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("mmap_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	auto front() -> reference {
+		return data()[0];
+	}
+
+	auto front() const -> const_reference {
+		return data()[0];
+	}
+
+	auto back() -> reference {
+		return data()[size() - 1];
+	}
+
+	auto back() const -> const_reference {
+		return data()[size() - 1];
+	}
+
+	// data access
+
+	auto data() noexcept -> Value* {
+		if(mapping_ == nullptr)
+			return nullptr;
+		return reinterpret_cast<Value*>(static_cast<char*>(mapping_) + data_offset);
+	}
+
+	auto data() const noexcept -> const Value* {
+		if(mapping_ == nullptr)
+			return nullptr;
+		return reinterpret_cast<const Value*>(static_cast<const char*>(mapping_) + data_offset);
+	}
+
+	// modifiers
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		if(size() == capacity()) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			reserve(grown_capacity());
+			return emplace_back(to_emplace);
+		}
+		::new(static_cast<void*>(end())) Value(std::forward<Args>(args)...);
+		header()->count += 1;
+		return back();
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	auto pop_back() noexcept -> void {
+		header()->count -= 1;
+	}
+
+	auto swap(mmap_vector& to_swap) noexcept -> void {
+		std::swap(descriptor_, to_swap.descriptor_);
+		std::swap(mapping_, to_swap.mapping_);
+		std::swap(mapped_bytes_, to_swap.mapped_bytes_);
+	}
+
+	auto clear() noexcept -> void {
+		if(mapping_ != nullptr)
+			header()->count = 0;
+	}
+
+	// Writes the dirty pages back and waits for the writes, like fsync.
+	auto flush() -> void {
+		if(mapping_ != nullptr && ::msync(mapping_, mapped_bytes_, MS_SYNC) != 0)
+			throw_errno("msync");
+	}
+
+private:
+
+	static constexpr std::size_t data_offset = vector_file_data_offset<Value>();
+
+	[[noreturn]]
+	static auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"mmap_vector : "} + call};
+	}
+
+	auto header() noexcept -> vector_file_header* {
+		return static_cast<vector_file_header*>(mapping_);
+	}
+
+	auto header() const noexcept -> const vector_file_header* {
+		return static_cast<const vector_file_header*>(mapping_);
+	}
+
+	// Twice the capacity, with the file rounded up to whole pages : the
+	// mapping holds them anyway, and small vectors would otherwise pay one
+	// ftruncate and mremap per doubling from a single element.
+	auto grown_capacity() const -> size_type {
+		auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		auto bytes = data_offset + (2 * capacity() + 1) * sizeof(Value);
+		bytes = (bytes + page - 1) / page * page;
+		return (bytes - data_offset) / sizeof(Value);
+	}
+
+	auto map(std::size_t bytes) -> void {
+		auto mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor_, 0);
+		if(mapping == MAP_FAILED)
+			throw_errno("mmap");
+		mapping_ = mapping;
+		mapped_bytes_ = bytes;
+	}
+
+	// Resizes the file to bytes, then the mapping to match.
+	auto remap(std::size_t bytes) -> void {
+		if(::ftruncate(descriptor_, static_cast<off_t>(bytes)) != 0)
+			throw_errno("ftruncate");
+		if(mapping_ == nullptr)
+			return map(bytes);
+#ifdef __linux__
+		auto mapping = ::mremap(mapping_, mapped_bytes_, bytes, MREMAP_MAYMOVE);
+		if(mapping == MAP_FAILED)
+			throw_errno("mremap");
+		mapping_ = mapping;
+		mapped_bytes_ = bytes;
+#else
+		::munmap(mapping_, mapped_bytes_);
+		mapping_ = nullptr;
+		map(bytes);
+#endif
+	}
+
+	auto close() noexcept -> void {
+		if(mapping_ != nullptr)
+			::munmap(mapping_, mapped_bytes_);
+		if(descriptor_ >= 0)
+			::close(descriptor_);
+	}
+
+	int descriptor_;
+	void* mapping_;
+	std::size_t mapped_bytes_;
+};
+
+template<class Value>
+void swap(mmap_vector<Value>& x, mmap_vector<Value>& y) noexcept {
+	x.swap(y);
+}
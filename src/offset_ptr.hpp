@@ -0,0 +1,183 @@
+#pragma once
+
+#include<cstddef>
+#include<cstdint>
+#include<functional>
+#include<iterator>
+#include<memory>
+#include<type_traits>
+
+// Fancy pointer storing the distance from itself to its pointee, so that a
+// structure of offset_ptrs stays valid wherever the memory holding it is
+// mapped, e.g. in shared memory mapped at another address by each process.
+// Copies compute their own offsets : offset_ptrs must not be copied with
+// memcpy, and only point within the mapping that holds them.
+
+template<class Value>
+class offset_ptr {
+public:
+
+	using element_type = Value;
+	using value_type = std::remove_cv_t<Value>;
+	using difference_type = std::ptrdiff_t;
+	using pointer = Value*;
+	using reference = std::add_lvalue_reference_t<Value>;
+	using iterator_category = std::random_access_iterator_tag;
+
+	template<class Other>
+	using rebind = offset_ptr<Other>;
+
+	offset_ptr() noexcept
+		: offset_{null_offset}
+	{}
+
+	offset_ptr(std::nullptr_t) noexcept
+		: offset_{null_offset}
+	{}
+
+	offset_ptr(Value* with_address) noexcept {
+		set(with_address);
+	}
+
+	offset_ptr(const offset_ptr& from_pointer) noexcept {
+		set(from_pointer.get());
+	}
+
+	template<class Other, class = std::enable_if_t<std::is_convertible_v<Other*, Value*>>>
+	offset_ptr(const offset_ptr<Other>& from_pointer) noexcept {
+		set(from_pointer.get());
+	}
+
+	auto operator=(const offset_ptr& from_pointer) noexcept -> offset_ptr& {
+		set(from_pointer.get());
+		return *this;
+	}
+
+	template<class V = Value>
+	static auto pointer_to(std::enable_if_t<!std::is_void_v<V>, V>& to_point) noexcept -> offset_ptr {
+		return offset_ptr{std::addressof(to_point)};
+	}
+
+	auto get() const noexcept -> Value* {
+		if(offset_ == null_offset)
+			return nullptr;
+		return reinterpret_cast<Value*>(reinterpret_cast<std::uintptr_t>(this) + offset_);
+	}
+
+	explicit operator bool() const noexcept {
+		return offset_ != null_offset;
+	}
+
+	auto operator*() const noexcept -> reference {
+		return *get();
+	}
+
+	auto operator->() const noexcept -> Value* {
+		return get();
+	}
+
+	auto operator[](difference_type offset) const noexcept -> reference {
+		return get()[offset];
+	}
+
+	auto operator++() noexcept -> offset_ptr& {
+		return *this += 1;
+	}
+
+	auto operator++(int) noexcept -> offset_ptr {
+		auto previous = *this;
+		*this += 1;
+		return previous;
+	}
+
+	auto operator--() noexcept -> offset_ptr& {
+		return *this -= 1;
+	}
+
+	auto operator--(int) noexcept -> offset_ptr {
+		auto previous = *this;
+		*this -= 1;
+		return previous;
+	}
+
+	auto operator+=(difference_type offset) noexcept -> offset_ptr& {
+		set(get() + offset);
+		return *this;
+	}
+
+	auto operator-=(difference_type offset) noexcept -> offset_ptr& {
+		set(get() - offset);
+		return *this;
+	}
+
+	friend auto operator+(offset_ptr p, difference_type offset) noexcept -> offset_ptr {
+		return p += offset;
+	}
+
+	friend auto operator+(difference_type offset, offset_ptr p) noexcept -> offset_ptr {
+		return p += offset;
+	}
+
+	friend auto operator-(offset_ptr p, difference_type offset) noexcept -> offset_ptr {
+		return p -= offset;
+	}
+
+	friend auto operator-(const offset_ptr& x, const offset_ptr& y) noexcept -> difference_type {
+		return x.get() - y.get();
+	}
+
+	friend auto operator==(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return x.get() == y.get();
+	}
+
+	friend auto operator!=(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return x.get() != y.get();
+	}
+
+	friend auto operator<(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return std::less<Value*>{}(x.get(), y.get());
+	}
+
+	friend auto operator>(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return y < x;
+	}
+
+	friend auto operator<=(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return !(y < x);
+	}
+
+	friend auto operator>=(const offset_ptr& x, const offset_ptr& y) noexcept -> bool {
+		return !(x < y);
+	}
+
+	friend auto operator==(const offset_ptr& p, std::nullptr_t) noexcept -> bool {
+		return !p;
+	}
+
+	friend auto operator==(std::nullptr_t, const offset_ptr& p) noexcept -> bool {
+		return !p;
+	}
+
+	friend auto operator!=(const offset_ptr& p, std::nullptr_t) noexcept -> bool {
+		return static_cast<bool>(p);
+	}
+
+	friend auto operator!=(std::nullptr_t, const offset_ptr& p) noexcept -> bool {
+		return static_cast<bool>(p);
+	}
+
+private:
+
+	// No object starts one byte into the offset_ptr itself.
+	static constexpr difference_type null_offset = 1;
+
+	auto set(Value* to_address) noexcept -> void {
+		if(to_address == nullptr)
+			offset_ = null_offset;
+		else
+			offset_ = static_cast<difference_type>(
+				reinterpret_cast<std::uintptr_t>(to_address) - reinterpret_cast<std::uintptr_t>(this));
+	}
+
+	difference_type offset_;
+};
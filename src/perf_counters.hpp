@@ -0,0 +1,131 @@
+#pragma once
+
+#include<array>
+#include<cstddef>
+#include<cstdint>
+
+#ifdef __linux__
+#include<cstring>
+#include<linux/perf_event.h>
+#include<sys/ioctl.h>
+#include<sys/syscall.h>
+#include<unistd.h>
+#endif
+
+// Hardware counters of the calling thread through perf_event_open, user space
+// only. Counters the kernel or the CPU refuses (perf_event_paranoid, virtual
+// machines, other platforms) stay unavailable and read as 0.
+
+class perf_counters {
+public:
+
+	static constexpr std::size_t count = 6;
+
+	static constexpr std::array<const char*, count> names = {
+		"cycles",
+		"instructions",
+		"l1d_misses",
+		"llc_misses",
+		"dtlb_misses",
+		"branch_misses",
+	};
+
+	perf_counters() noexcept {
+		descriptors_.fill(-1);
+#ifdef __linux__
+		auto cache_miss = [](std::uint64_t cache) {
+			return cache
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+				| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		};
+		open(0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		open(1, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		open(2, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D));
+		open(3, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL));
+		open(4, PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB));
+		open(5, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+	}
+
+	perf_counters(const perf_counters&) = delete;
+
+	auto operator=(const perf_counters&) -> perf_counters& = delete;
+
+	~perf_counters() {
+#ifdef __linux__
+		for(auto descriptor : descriptors_)
+			if(descriptor >= 0)
+				close(descriptor);
+#endif
+	}
+
+	auto available() const noexcept -> bool {
+		for(auto i = std::size_t{0}; i < count; ++i)
+			if(available(i))
+				return true;
+		return false;
+	}
+
+	auto available(std::size_t counter) const noexcept -> bool {
+		return descriptors_[counter] >= 0;
+	}
+
+	auto reset() noexcept -> void {
+#ifdef __linux__
+		control(PERF_EVENT_IOC_RESET);
+#endif
+	}
+
+	auto start() noexcept -> void {
+#ifdef __linux__
+		control(PERF_EVENT_IOC_ENABLE);
+#endif
+	}
+
+	auto stop() noexcept -> void {
+#ifdef __linux__
+		control(PERF_EVENT_IOC_DISABLE);
+#endif
+	}
+
+	// Counts since the last reset, scaled up when the kernel had to multiplex.
+	auto read() const noexcept -> std::array<double, count> {
+		auto values = std::array<double, count>{};
+#ifdef __linux__
+		for(auto i = std::size_t{0}; i < count; ++i) {
+			if(!available(i))
+				continue;
+			std::uint64_t value[3] = {};
+			if(::read(descriptors_[i], value, sizeof(value)) != sizeof(value) || value[2] == 0)
+				continue;
+			values[i] = static_cast<double>(value[0]) * value[1] / value[2];
+		}
+#endif
+		return values;
+	}
+
+private:
+
+#ifdef __linux__
+	auto open(std::size_t counter, std::uint32_t type, std::uint64_t config) noexcept -> void {
+		auto attributes = perf_event_attr{};
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = type;
+		attributes.config = config;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		descriptors_[counter] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+	}
+
+	auto control(unsigned long request) noexcept -> void {
+		for(auto descriptor : descriptors_)
+			if(descriptor >= 0)
+				ioctl(descriptor, request, 0);
+	}
+#endif
+
+	std::array<int, count> descriptors_;
+};
@@ -0,0 +1,297 @@
+#pragma once
+
+#include<atomic>
+#include<cerrno>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<new>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<utility>
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include "offset_ptr.hpp"
+#include "vector.hpp"
+
+// Allocator over a POSIX shared memory object, with offset_ptr pointers, so
+// that a vector built in the segment, allocator included, can be read by
+// every process mapping it, wherever the mapping lands. The segment is a bump
+// allocator like vector_arena : only the last block is given back, and the
+// rest is reclaimed when the shared memory object is removed. Writes and
+// reads from different processes must be synchronized by the caller.
+
+namespace shm_detail {
+
+	[[noreturn]]
+	inline auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"shm_segment : "} + call};
+	}
+
+	constexpr char magic[8] = {'S', 'H', 'M', 'V', 'E', 'C', '0', '1'};
+
+	// Start of the segment, and the allocator's state shared by every process.
+	class heap {
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shm_segment : needs lock-free 64 bit atomics");
+
+	public:
+
+		explicit
+		heap(std::uint64_t with_bytes) noexcept
+			: bytes_{with_bytes}
+			, top_{sizeof(heap)}
+		{
+			std::memcpy(magic_, magic, sizeof(magic));
+		}
+
+		auto valid() const noexcept -> bool {
+			return std::memcmp(magic_, magic, sizeof(magic)) == 0;
+		}
+
+		auto bytes() const noexcept -> std::size_t {
+			return static_cast<std::size_t>(bytes_);
+		}
+
+		auto used_bytes() const noexcept -> std::size_t {
+			return static_cast<std::size_t>(top_.load(std::memory_order_acquire));
+		}
+
+		auto allocate(std::size_t bytes, std::size_t alignment) -> void* {
+			auto base = reinterpret_cast<std::uintptr_t>(this);
+			auto top = top_.load(std::memory_order_relaxed);
+			for(;;) {
+				auto begin = (base + top + alignment - 1) & ~(alignment - 1);
+				auto offset = begin - base;
+				if(offset > bytes_ || bytes > bytes_ - offset)
+					throw std::bad_alloc{};
+				if(top_.compare_exchange_weak(top, offset + bytes, std::memory_order_acq_rel, std::memory_order_relaxed))
+					return reinterpret_cast<void*>(begin);
+			}
+		}
+
+		// Gives the block back only if it is the last one allocated.
+		auto deallocate(void* p, std::size_t bytes) noexcept -> void {
+			auto offset = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(this));
+			auto end = offset + bytes;
+			top_.compare_exchange_strong(end, offset, std::memory_order_acq_rel, std::memory_order_relaxed);
+		}
+
+		auto root() const noexcept -> void* {
+			return root_.get();
+		}
+
+		auto set_root(void* to_root) noexcept -> void {
+			root_ = to_root;
+		}
+
+	private:
+
+		char magic_[8];
+		std::uint64_t bytes_;
+		std::atomic<std::uint64_t> top_;
+		offset_ptr<void> root_;
+	};
+}
+
+template<class Value>
+class shm_allocator;
+
+// Mapping of a named shared memory object, see shm_open(3).
+class shm_segment {
+public:
+
+	// Opens the segment name, or creates one of bytes there. The creating
+	// process must be done creating before another one opens it.
+	shm_segment(const char* name, std::size_t bytes)
+		: descriptor_{::shm_open(name, O_RDWR | O_CREAT, 0600)}
+		, mapping_{nullptr}
+		, bytes_{0}
+	{
+		if(descriptor_ < 0)
+			shm_detail::throw_errno("shm_open");
+		try {
+			if(file_bytes() == 0) {
+				if(bytes < sizeof(shm_detail::heap))
+					throw std::length_error{"shm_segment : bytes too small"};
+				if(::ftruncate(descriptor_, static_cast<off_t>(bytes)) != 0)
+					shm_detail::throw_errno("ftruncate");
+				map(bytes);
+				new(mapping_) shm_detail::heap{bytes};
+			}
+			else
+				open();
+		}
+		catch(...) {
+			close();
+			throw;
+		}
+	}
+
+	// Opens the existing segment name.
+	explicit
+	shm_segment(const char* name)
+		: descriptor_{::shm_open(name, O_RDWR, 0600)}
+		, mapping_{nullptr}
+		, bytes_{0}
+	{
+		if(descriptor_ < 0)
+			shm_detail::throw_errno("shm_open");
+		try {
+			open();
+		}
+		catch(...) {
+			close();
+			throw;
+		}
+	}
+
+	shm_segment(const shm_segment&) = delete;
+
+	shm_segment(shm_segment&& from_segment) noexcept
+		: descriptor_{std::exchange(from_segment.descriptor_, -1)}
+		, mapping_{std::exchange(from_segment.mapping_, nullptr)}
+		, bytes_{std::exchange(from_segment.bytes_, 0)}
+	{}
+
+	~shm_segment() {
+		close();
+	}
+
+	auto operator=(const shm_segment&) -> shm_segment& = delete;
+
+	// Removes the name. Mappings stay valid until they are closed.
+	static auto remove(const char* name) noexcept -> bool {
+		return ::shm_unlink(name) == 0;
+	}
+
+	auto bytes() const noexcept -> std::size_t {
+		return bytes_;
+	}
+
+	auto used_bytes() const noexcept -> std::size_t {
+		return heap()->used_bytes();
+	}
+
+	auto allocate(std::size_t bytes, std::size_t alignment) -> void* {
+		return heap()->allocate(bytes, alignment);
+	}
+
+	auto deallocate(void* p, std::size_t bytes) noexcept -> void {
+		heap()->deallocate(p, bytes);
+	}
+
+	// Builds the object other processes find with root<Value>(), e.g. a
+	// vector with a shm_allocator of this segment.
+	template<class Value, class... Args>
+	auto construct_root(Args&&... args) -> Value& {
+		auto p = allocate(sizeof(Value), alignof(Value));
+		auto root = new(p) Value(std::forward<Args>(args)...);
+		heap()->set_root(root);
+		return *root;
+	}
+
+	// The object built by construct_root, or nullptr.
+	template<class Value>
+	auto root() const noexcept -> Value* {
+		return static_cast<Value*>(heap()->root());
+	}
+
+private:
+
+	template<class Value>
+	friend class shm_allocator;
+
+	auto heap() const noexcept -> shm_detail::heap* {
+		return static_cast<shm_detail::heap*>(mapping_);
+	}
+
+	auto file_bytes() const -> std::size_t {
+		struct stat status;
+		if(::fstat(descriptor_, &status) != 0)
+			shm_detail::throw_errno("fstat");
+		return static_cast<std::size_t>(status.st_size);
+	}
+
+	auto open() -> void {
+		auto bytes = file_bytes();
+		if(bytes < sizeof(shm_detail::heap))
+			throw std::runtime_error{"shm_segment : not a segment"};
+		map(bytes);
+		if(!heap()->valid() || heap()->bytes() != bytes)
+			throw std::runtime_error{"shm_segment : not a segment"};
+	}
+
+	auto map(std::size_t bytes) -> void {
+		auto mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor_, 0);
+		if(mapping == MAP_FAILED)
+			shm_detail::throw_errno("mmap");
+		mapping_ = mapping;
+		bytes_ = bytes;
+	}
+
+	auto close() noexcept -> void {
+		if(mapping_ != nullptr)
+			::munmap(mapping_, bytes_);
+		if(descriptor_ >= 0)
+			::close(descriptor_);
+		mapping_ = nullptr;
+		descriptor_ = -1;
+	}
+
+	int descriptor_;
+	void* mapping_;
+	std::size_t bytes_;
+};
+
+// Allocates from a shm_segment. It refers to the segment through an
+// offset_ptr, so it is valid inside the segment in every process.
+template<class Value>
+class shm_allocator {
+public:
+
+	using value_type = Value;
+	using pointer = offset_ptr<Value>;
+
+	shm_allocator(shm_segment& with_segment) noexcept
+		: heap_{with_segment.heap()}
+	{}
+
+	template<class Other>
+	shm_allocator(const shm_allocator<Other>& from_allocator) noexcept
+		: heap_{from_allocator.heap()}
+	{}
+
+	auto allocate(std::size_t n) -> pointer {
+		return static_cast<Value*>(heap_->allocate(n * sizeof(Value), alignof(Value)));
+	}
+
+	auto deallocate(pointer p, std::size_t n) noexcept -> void {
+		heap_->deallocate(p.get(), n * sizeof(Value));
+	}
+
+	auto heap() const noexcept -> shm_detail::heap* {
+		return heap_.get();
+	}
+
+private:
+
+	offset_ptr<shm_detail::heap> heap_;
+};
+
+template<class Value, class Other>
+auto operator==(const shm_allocator<Value>& x, const shm_allocator<Other>& y) noexcept -> bool {
+	return x.heap() == y.heap();
+}
+
+template<class Value, class Other>
+auto operator!=(const shm_allocator<Value>& x, const shm_allocator<Other>& y) noexcept -> bool {
+	return !(x == y);
+}
+
+template<class Value>
+using shm_vector = vector<Value, shm_allocator<Value>>;
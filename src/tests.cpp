@@ -1,7 +1,37 @@
 #define CATCH_CONFIG_MAIN
 #include <Catch2/catch.hpp>
 
+#include "aligned_allocator.hpp"
+#include "bench_report.hpp"
+#include "bulk_loader.hpp"
+#include "counting_allocator.hpp"
+#include "devector.hpp"
+#include "external_sort.hpp"
+#include "external_vector.hpp"
+#include "gap_vector.hpp"
+#include "incremental_vector.hpp"
+#include "inplace_vector.hpp"
+#include "latency_histogram.hpp"
+#include "mapped_view.hpp"
+#include "mmap_vector.hpp"
+#include "perf_counters.hpp"
+#include "shm_allocator.hpp"
+#include "thin_vector.hpp"
 #include "vector.hpp"
+#include "vector_arena.hpp"
+#include "vector_io.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 TEST_CASE("vectors can be default constructed") {
     auto v = vector<int>{};
@@ -9,3 +39,862 @@ TEST_CASE("vectors can be default constructed") {
     REQUIRE(v.capacity() == 0);
     REQUIRE(v.size() == 0);
 }
+
+TEST_CASE("vectors insert, erase and copy") {
+    auto v = vector<std::string>{};
+    for(auto i = 0; i < 6; ++i)
+        v.emplace_back(std::to_string(i));
+
+    v.insert(v.begin() + 2, "a");
+    v.erase(v.begin(), v.begin() + 2);
+    v.insert(v.end(), v.front());
+
+    auto copy = v;
+    auto expected = std::vector<std::string>{"a", "2", "3", "4", "5", "a"};
+    REQUIRE(copy.size() == expected.size());
+    REQUIRE(std::equal(copy.begin(), copy.end(), expected.begin()));
+
+    v.clear();
+    REQUIRE(v.empty());
+    v = std::move(copy);
+    REQUIRE(v.size() == expected.size());
+}
+
+TEST_CASE("gap_vectors insert and erase around a moving gap") {
+    auto v = gap_vector<int>{};
+    for(auto i = 0; i < 8; ++i)
+        v.push_back(i);
+
+    auto it = v.insert(v.begin() + 3, 30);
+    REQUIRE(*it == 30);
+    REQUIRE(v.gap_position() == 4);
+    v.insert(v.begin() + 4, 31);
+    v.insert(v.begin() + 1, 10);
+    v.erase(v.begin() + 6);
+
+    auto expected = std::vector<int>{0, 10, 1, 2, 30, 31, 4, 5, 6, 7};
+    REQUIRE(v.size() == expected.size());
+    REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+    REQUIRE(v.back() == 7);
+}
+
+TEST_CASE("gap_vectors keep their values across reallocations") {
+    auto v = gap_vector<std::string>{};
+    for(auto i = 0; i < 100; ++i)
+        v.insert(v.begin() + i / 2, std::to_string(i));
+
+    auto copy = v;
+    REQUIRE(copy.size() == 100);
+    REQUIRE(std::equal(copy.begin(), copy.end(), v.begin()));
+    REQUIRE(v[49] == "99");
+}
+
+// Marks the elements it is moved from. The mark is volatile, so it is still
+// there to see when a buggy container copies an element it already moved.
+struct move_marked {
+    volatile int value;
+
+    move_marked(int with_value) : value{with_value} {}
+    move_marked(const move_marked& from) : value{from.value} {}
+    move_marked(move_marked&& from) noexcept : value{from.value} { from.value = -1; }
+
+    auto operator=(const move_marked& from) -> move_marked& {
+        value = from.value;
+        return *this;
+    }
+
+    auto operator=(move_marked&& from) noexcept -> move_marked& {
+        value = from.value;
+        from.value = -1;
+        return *this;
+    }
+};
+
+TEST_CASE("gap_vectors insert copies of their own elements") {
+    auto v = gap_vector<move_marked>{};
+    for(auto i = 0; i < 8; ++i)
+        v.push_back(i);
+
+    v.insert(v.begin(), v[5]);
+    REQUIRE(v[0].value == 5);
+    while(v.size() < v.capacity())
+        v.push_back(9);
+    v.insert(v.begin() + 2, v.back());
+    REQUIRE(v[2].value == 9);
+}
+
+TEST_CASE("vectors push_back copies of their own elements") {
+    auto v = vector<move_marked>{};
+    v.reserve(3);
+    for(auto i = 1; i <= 3; ++i)
+        v.push_back(i);
+
+    v.push_back(v[0]);
+    REQUIRE(v.size() == 4);
+    REQUIRE(v[3].value == 1);
+    v.shrink_to_fit();
+    v.push_back(std::move(v[1]));
+    REQUIRE(v[4].value == 2);
+
+    auto strings = vector<std::string>{};
+    strings.reserve(3);
+    for(auto i = 0; i < 3; ++i)
+        strings.push_back("a string long enough to live on the heap " + std::to_string(i));
+    strings.push_back(strings[0]);
+    REQUIRE(strings[3] == strings[0]);
+}
+
+TEST_CASE("vector instrumentation counts allocations and relocations") {
+    struct tagged { int value; };
+    {
+        auto v = vector<tagged>{};
+        for(auto i = 0; i < 4; ++i)
+            v.push_back(tagged{i});
+        v.pop_back();
+
+        auto stats = vector_stats_for<vector<tagged>>().snapshot();
+        REQUIRE(stats.allocations == 3);
+        REQUIRE(stats.deallocations == 2);
+        REQUIRE(stats.reallocations == 2);
+        REQUIRE(stats.relocated_elements == 1 + 3);
+        REQUIRE(stats.relocated_bytes == 4 * sizeof(tagged));
+        // 3 and 7 elements are both live while the last growth relocates.
+        REQUIRE(stats.peak_capacity == 3 + 7);
+        REQUIRE(stats.slack() == 7 - 3);
+    }
+
+    auto snapshots = vector_stats_snapshots();
+    auto stats = std::find_if(snapshots.begin(), snapshots.end(), [](auto& s) {
+        return s.name == vector_stats_for<vector<tagged>>().snapshot().name;
+    });
+    REQUIRE(stats != snapshots.end());
+    REQUIRE(stats->deallocations == 3);
+    REQUIRE(stats->live_capacity == 0);
+    REQUIRE(stats->slack() == 0);
+
+    auto first = vector<tagged>{};
+    auto second = vector<tagged>{};
+    first.reserve(20);
+    second.reserve(30);
+    REQUIRE(vector_stats_for<vector<tagged>>().snapshot().peak_capacity == 50);
+}
+
+TEST_CASE("benchmark results round-trip and regressions are detected") {
+    auto baseline = std::vector<bench_result>{
+        {"vector push_back int x 16", "vector", "push_back", "int", 16, 100, 5, 124, {}},
+        {"vector copy int x 16", "vector", "copy", "int", 16, 20, 1, 64, {}},
+    };
+    auto file = std::stringstream{};
+    write_bench_results(file, baseline);
+    auto read = read_bench_results(file);
+
+    REQUIRE(read.size() == 2);
+    REQUIRE(read[0].name == "vector push_back int x 16");
+    REQUIRE(read[0].element_type == "int");
+    REQUIRE(read[0].n == 16);
+    REQUIRE(read[1].ns_per_op == 20);
+    REQUIRE(read[1].bytes_per_op == 64);
+
+    auto candidate = read;
+    candidate[0].ns_per_op = 109;
+    REQUIRE(compare_bench_results(baseline, candidate, 0.1).empty());
+    candidate[0].ns_per_op = 111;
+    candidate[1].allocations_per_op = 2;
+    auto regressions = compare_bench_results(baseline, candidate, 0.1);
+    REQUIRE(regressions.size() == 2);
+    REQUIRE(regressions[0].metric == "ns_per_op");
+    REQUIRE(regressions[1].metric == "allocations_per_op");
+}
+
+TEST_CASE("latency histograms report percentiles within their precision") {
+    auto histogram = latency_histogram<>{};
+    for(auto value = 1u; value <= 100'000u; ++value)
+        histogram.record(value);
+
+    REQUIRE(histogram.count() == 100'000);
+    REQUIRE(histogram.max() == 100'000);
+    REQUIRE(histogram.percentile(0.0) == 1);
+    REQUIRE(histogram.percentile(0.5) == Approx(50'000).epsilon(0.02));
+    REQUIRE(histogram.percentile(0.99) == Approx(99'000).epsilon(0.02));
+    REQUIRE(histogram.percentile(0.999) == Approx(99'900).epsilon(0.02));
+    REQUIRE(histogram.percentile(1.0) == 100'000);
+}
+
+TEST_CASE("incremental_vectors relocate a bounded number of elements per push_back") {
+    auto v = incremental_vector<std::string, std::allocator<std::string>, 2>{};
+    for(auto i = 0; i < 7; ++i)
+        v.push_back(std::to_string(i));
+    REQUIRE(!v.migrating());
+    REQUIRE(v.capacity() == 7);
+
+    v.push_back("7");
+    REQUIRE(v.migrating());
+    REQUIRE(v.capacity() == 15);
+    for(auto i = 0; i < 8; ++i)
+        REQUIRE(v[i] == std::to_string(i));
+
+    v.push_back("8");
+    v.pop_back();
+    REQUIRE(v.migrating());
+    REQUIRE(std::equal(v.begin(), v.end(), std::vector<std::string>{"0", "1", "2", "3", "4", "5", "6", "7"}.begin()));
+
+    v.finish_migration();
+    REQUIRE(!v.migrating());
+    REQUIRE(v.data()[6] == "6");
+}
+
+TEST_CASE("incremental_vectors stay intact when growth fails") {
+    auto counter = allocation_counter{};
+    auto v = incremental_vector<int, counting_allocator<int>>{counting_allocator<int>{counter}};
+    for(auto i = 0; i < 3; ++i)
+        v.push_back(i);
+    counter.seal();
+
+    REQUIRE_THROWS_AS(v.push_back(3), forbidden_allocation);
+    REQUIRE(!v.migrating());
+    REQUIRE(v.size() == 3);
+    REQUIRE(v.capacity() == 3);
+    REQUIRE(v[2] == 2);
+
+    counter.unseal();
+    v.push_back(3);
+    REQUIRE(std::equal(v.begin(), v.end(), std::vector<int>{0, 1, 2, 3}.begin()));
+}
+
+TEST_CASE("hardware counters round-trip through benchmark results") {
+    auto counters = perf_counters{};
+    counters.reset();
+    counters.start();
+    auto sum = 0;
+    for(auto i = 0; i < 1000; ++i)
+        sum += i;
+    counters.stop();
+    auto values = counters.read();
+    if(counters.available(1))
+        REQUIRE(values[1] > 0);
+    else
+        REQUIRE(values[1] == 0);
+    REQUIRE(sum == 499500);
+
+    auto result = bench_result{"vector copy int x 16", "vector", "copy", "int", 16, 10, 1, 64, {}};
+    result.counters = {{"cycles", 40}, {"l1d_misses", 0.5}};
+    auto file = std::stringstream{};
+    write_bench_results(file, {result});
+    auto read = read_bench_results(file);
+
+    REQUIRE(read.size() == 1);
+    REQUIRE(read[0].bytes_per_op == 64);
+    REQUIRE(read[0].counters == result.counters);
+}
+
+TEST_CASE("vectors reusing their capacity never allocate") {
+    auto counter = allocation_counter{};
+    auto v = vector<std::string, counting_allocator<std::string>>{counting_allocator<std::string>{counter}};
+    v.reserve(64);
+    auto source = std::vector<std::string>(48, "a string long enough to live on the heap");
+    counter.seal();
+
+    SECTION("clear and refill") {
+        for(auto round = 0; round < 10; ++round) {
+            v.clear();
+            for(auto i = 0; i < 64; ++i)
+                v.emplace_back();
+        }
+        REQUIRE(v.size() == 64);
+    }
+    SECTION("assign") {
+        v.assign(64, std::string{});
+        v.assign(source.begin(), source.end());
+        v.assign({std::string{}, std::string{}});
+        REQUIRE(v.size() == 2);
+    }
+    SECTION("resize") {
+        v.resize(64);
+        v.resize(3);
+        v.resize(50, std::string{});
+        REQUIRE(v.size() == 50);
+    }
+
+    REQUIRE(counter.allocations == 1);
+    REQUIRE(counter.forbidden_allocations == 0);
+}
+
+TEST_CASE("sealed allocation counters reject growth") {
+    auto counter = allocation_counter{};
+    auto v = vector<int, counting_allocator<int>>{counting_allocator<int>{counter}};
+    v.reserve(2);
+    v.push_back(1);
+    v.push_back(2);
+    counter.seal();
+
+    REQUIRE_THROWS_AS(v.push_back(3), forbidden_allocation);
+    REQUIRE(counter.forbidden_allocations == 1);
+    REQUIRE(v.size() == 2);
+    REQUIRE(v.capacity() == 2);
+}
+
+TEST_CASE("try_push_back never grows a vector") {
+    auto v = vector<int>{};
+    v.reserve(2);
+    v.seal();
+    REQUIRE(v.sealed());
+
+    REQUIRE(v.try_push_back(1));
+    REQUIRE(v.try_emplace_back(2));
+    REQUIRE(!v.try_push_back(3));
+    REQUIRE(v.size() == 2);
+    REQUIRE(v.capacity() == 2);
+
+    v.unseal();
+    v.push_back(3);
+    REQUIRE(v.capacity() > 2);
+}
+
+TEST_CASE("vectors adopt and release buffers without copying") {
+    using allocator = counting_allocator<int>;
+    auto counter = allocation_counter{};
+    auto alloc = allocator{counter};
+    auto buffer = alloc.allocate(8);
+    for(auto i = 0; i < 3; ++i)
+        std::allocator_traits<allocator>::construct(alloc, buffer + i, i + 1);
+    counter.seal();
+
+    auto v = vector<int, allocator>::adopt(buffer, 3, 8, alloc);
+    REQUIRE(v.data() == buffer);
+    REQUIRE(v.size() == 3);
+    REQUIRE(v.capacity() == 8);
+    v.push_back(4);
+    REQUIRE(v.back() == 4);
+
+    auto released = v.release();
+    REQUIRE(v.empty());
+    REQUIRE(v.capacity() == 0);
+    REQUIRE(released.data == buffer);
+    REQUIRE(released.size == 4);
+    REQUIRE(released.capacity == 8);
+
+    auto w = vector<int, allocator>::adopt(released.data, released.size, released.capacity, alloc);
+    REQUIRE(std::equal(w.begin(), w.end(), std::vector<int>{1, 2, 3, 4}.begin()));
+    REQUIRE(counter.allocations == 1);
+    REQUIRE(counter.deallocations == 0);
+    w = vector<int, allocator>{alloc};
+    REQUIRE(counter.deallocations == 1);
+}
+
+constexpr auto make_inplace_vector() -> inplace_vector<int, 16> {
+    auto v = inplace_vector<int, 16>{3, 1};
+    v.insert(v.begin(), 2);
+    v.erase(v.begin() + 1);
+    v.push_back(4);
+    return v;
+}
+
+static_assert(make_inplace_vector().size() == 3);
+static_assert(make_inplace_vector()[0] == 2 && make_inplace_vector()[2] == 4);
+
+TEST_CASE("inplace_vectors store up to their capacity without allocating") {
+    static_assert(sizeof(inplace_vector<int, 16>) == sizeof(std::size_t) + 16 * sizeof(int));
+
+    auto v = inplace_vector<std::string, 4>{"a", "b"};
+    v.emplace_back("c");
+    v.insert(v.begin(), "z");
+    REQUIRE(v.size() == 4);
+    REQUIRE(!v.try_push_back("d"));
+    REQUIRE_THROWS_AS(v.push_back("d"), std::bad_alloc);
+
+    auto copy = v;
+    v.erase(v.begin(), v.begin() + 2);
+    REQUIRE(std::equal(v.begin(), v.end(), std::vector<std::string>{"b", "c"}.begin()));
+
+    swap(v, copy);
+    REQUIRE(v.size() == 4);
+    REQUIRE(copy.size() == 2);
+    REQUIRE(v.front() == "z");
+    REQUIRE(copy.back() == "c");
+}
+
+TEST_CASE("thin_vectors are one pointer and keep their sizes on the heap") {
+    static_assert(sizeof(thin_vector<int>) == sizeof(void*));
+
+    auto empty = thin_vector<std::string>{};
+    auto other_empty = thin_vector<std::string>{};
+    REQUIRE(empty.capacity() == 0);
+    REQUIRE(empty.data() == other_empty.data());
+
+    auto v = thin_vector<std::string>{"b", "c"};
+    v.insert(v.begin(), "a");
+    for(auto i = 0; i < 20; ++i)
+        v.push_back(std::to_string(i));
+    v.erase(v.begin() + 3, v.end() - 1);
+    REQUIRE(std::equal(v.begin(), v.end(), std::vector<std::string>{"a", "b", "c", "19"}.begin()));
+
+    auto copy = v;
+    v.clear();
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == 0);
+    REQUIRE(v.data() == empty.data());
+    REQUIRE(copy.size() == 4);
+    REQUIRE(copy.capacity() == 4);
+
+    struct alignas(32) over_aligned { int value; };
+    auto aligned = thin_vector<over_aligned>{};
+    aligned.push_back({1});
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned.data()) % 32 == 0);
+}
+
+TEST_CASE("arena vectors share slabs that are freed together") {
+    auto arena = vector_arena{1024};
+    {
+        auto vectors = std::vector<arena_vector<int>>(64, arena_vector<int>{arena});
+        for(auto i = 0; i < 64; ++i)
+            for(auto j = 0; j < i % 8; ++j)
+                vectors[i].push_back(i + j);
+        REQUIRE(vectors[9].size() == 1);
+        REQUIRE(vectors[9][0] == 9);
+        REQUIRE(vectors[63].back() == 63 + 6);
+        REQUIRE(vectors[0].get_allocator() == vectors[1].get_allocator());
+
+        struct alignas(64) over_aligned { int value; };
+        auto aligned = arena_vector<over_aligned>{arena};
+        aligned.push_back({1});
+        REQUIRE(reinterpret_cast<std::uintptr_t>(aligned.data()) % 64 == 0);
+    }
+    REQUIRE(arena.slab_count() > 1);
+
+    // Dropping the most recent block gives its space back.
+    auto first = static_cast<int*>(nullptr);
+    {
+        auto v = arena_vector<int>{arena};
+        v.reserve(100);
+        first = v.data();
+    }
+    auto w = arena_vector<int>{arena};
+    w.reserve(100);
+    REQUIRE(w.data() == first);
+
+    arena.release();
+    REQUIRE(arena.slab_count() == 0);
+    REQUIRE(arena.reserved_bytes() == 0);
+}
+
+TEST_CASE("compacting an arena packs its vectors into one exact slab") {
+    auto arena = vector_arena{256};
+    auto small = arena_vector<int>{arena};
+    auto text = arena_vector<std::string>{arena};
+    auto empty = arena_vector<double>{arena};
+    for(auto i = 0; i < 100; ++i) {
+        small.push_back(i);
+        text.push_back(std::to_string(i));
+        empty.push_back(i);
+    }
+    empty.clear();
+    REQUIRE(arena.slab_count() > 1);
+
+    compact(small, text, empty);
+
+    REQUIRE(arena.slab_count() == 1);
+    REQUIRE(arena.reserved_bytes() == 100 * sizeof(int) + 100 * sizeof(std::string));
+    REQUIRE(small.capacity() == 100);
+    REQUIRE(text.capacity() == 100);
+    REQUIRE(empty.capacity() == 0);
+    REQUIRE(small[42] == 42);
+    REQUIRE(text[99] == "99");
+
+    auto other_arena = vector_arena{};
+    auto stranger = arena_vector<int>{other_arena};
+    REQUIRE_THROWS_AS(compact(small, stranger), std::invalid_argument);
+
+    auto v = vector<int>{};
+    v.push_back(1);
+    v.push_back(2);
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == 2);
+    v.clear();
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == 0);
+    REQUIRE(v.data() == nullptr);
+}
+
+TEST_CASE("devector grows at both ends") {
+    auto v = devector<std::string>{"payload"};
+    v.reserve_front(3);
+    auto data = v.data();
+    REQUIRE(v.front_free_capacity() == 2);
+    v.push_front("length");
+    v.push_front("type");
+    REQUIRE(v.data() == data - 2);
+    REQUIRE(v.front_free_capacity() == 0);
+
+    for(auto i = 0; i < 10; ++i) {
+        v.push_front(std::to_string(-i));
+        v.push_back(std::to_string(i));
+    }
+    REQUIRE(v.size() == 23);
+    REQUIRE(v.front() == "-9");
+    REQUIRE(v[10] == "type");
+    REQUIRE(v.back() == "9");
+
+    auto reference = std::vector<std::string>(v.begin(), v.end());
+    v.insert(v.begin() + 2, "a");
+    reference.insert(reference.begin() + 2, "a");
+    v.insert(v.end() - 2, "b");
+    reference.insert(reference.end() - 2, "b");
+    v.erase(v.begin() + 1, v.begin() + 4);
+    reference.erase(reference.begin() + 1, reference.begin() + 4);
+    v.erase(v.end() - 3);
+    reference.erase(reference.end() - 3);
+    REQUIRE(std::equal(v.begin(), v.end(), reference.begin(), reference.end()));
+
+    auto copy = v;
+    v.pop_front();
+    v.pop_back();
+    REQUIRE(copy.size() == v.size() + 2);
+    v.clear();
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == 0);
+}
+
+TEST_CASE("devectors allocate like vectors") {
+    auto aligned = devector<int, aligned_allocator<int, 64>>{};
+    aligned.push_back(1);
+    REQUIRE(aligned.capacity() == 16);
+    REQUIRE(aligned.back_free_capacity() == 15);
+    aligned.push_front(0);
+    REQUIRE(aligned.capacity() % 16 == 0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned.data() - aligned.front_free_capacity()) % 64 == 0);
+    aligned.shrink_to_fit();
+    REQUIRE(aligned.capacity() == 16);
+    auto data = aligned.data();
+    aligned.shrink_to_fit();
+    REQUIRE(aligned.data() == data);
+
+    auto name = "/cpp_std_vector_devector_" + std::to_string(::getpid());
+    auto segment = shm_segment{name.c_str(), 1 << 16};
+    shm_segment::remove(name.c_str());
+    auto shared = devector<int, shm_allocator<int>>{shm_allocator<int>{segment}};
+    for(auto i = 0; i < 100; ++i) {
+        shared.push_front(-i);
+        shared.push_back(i);
+    }
+    REQUIRE(shared.size() == 200);
+    REQUIRE(shared.front() == -99);
+    REQUIRE(shared.back() == 99);
+    REQUIRE(segment.used_bytes() > 200 * sizeof(int));
+}
+
+TEST_CASE("mmap_vector keeps its elements in the file") {
+    char path[] = "/tmp/mmap_vector_XXXXXX";
+    ::close(::mkstemp(path));
+    {
+        auto v = mmap_vector<std::uint64_t>{path};
+        REQUIRE(v.empty());
+        v.push_back(0);
+        auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        REQUIRE(vector_file_data_offset<std::uint64_t>() + v.capacity() * sizeof(std::uint64_t) == page);
+        v.clear();
+        for(auto i = std::uint64_t{0}; i < 5000; ++i)
+            v.push_back(i * i);
+        v.pop_back();
+        v.flush();
+    }
+    {
+        auto v = mmap_vector<std::uint64_t>{path};
+        REQUIRE(v.size() == 4999);
+        REQUIRE(v[1234] == 1234 * 1234);
+        v.shrink_to_fit();
+        REQUIRE(v.capacity() == 4999);
+        v.resize(6000, 7);
+        REQUIRE(v.back() == 7);
+
+        auto moved = std::move(v);
+        REQUIRE(moved.size() == 6000);
+        REQUIRE(v.empty());
+        REQUIRE(v.size() == 0);
+        REQUIRE(v.capacity() == 0);
+        REQUIRE(v.begin() == v.end());
+        v.clear();
+        v.flush();
+    }
+    REQUIRE_THROWS_AS(mmap_vector<std::uint32_t>{path}, std::runtime_error);
+    std::remove(path);
+}
+
+TEST_CASE("mapped_view reads a vector file in place") {
+    char path[] = "/tmp/mapped_view_XXXXXX";
+    ::close(::mkstemp(path));
+    {
+        auto written = mmap_vector<double>{path};
+        for(auto i = 0; i < 1000; ++i)
+            written.push_back(i / 2.0);
+    }
+
+    auto view = mapped_view<double>{path, mapped_access::sequential, true};
+    REQUIRE(view.size() == 1000);
+    REQUIRE(view[3] == 1.5);
+    REQUIRE(view.back() == 499.5);
+    REQUIRE(std::is_sorted(view.begin(), view.end()));
+    view.advise(mapped_access::random);
+    REQUIRE_THROWS_AS(view.at(1000), std::out_of_range);
+
+    REQUIRE_THROWS_AS(mapped_view<float>{path}, std::runtime_error);
+    std::remove(path);
+    REQUIRE(view.front() == 0.0);
+}
+
+TEST_CASE("vectors save and load as a header and a raw block") {
+    struct point { float x; float y; };
+    char path[] = "/tmp/vector_io_XXXXXX";
+    auto descriptor = ::mkstemp(path);
+
+    auto saved = vector<point>{};
+    for(auto i = 0; i < 10000; ++i)
+        saved.push_back({static_cast<float>(i), -static_cast<float>(i)});
+    save(saved, descriptor);
+    save(vector<point>{}, descriptor);
+
+    ::lseek(descriptor, 0, SEEK_SET);
+    auto loaded = load<point>(descriptor);
+    REQUIRE(loaded.size() == 10000);
+    REQUIRE(loaded[1234].x == 1234);
+    REQUIRE(loaded.back().y == -9999);
+    REQUIRE(load<point>(descriptor).empty());
+    REQUIRE_THROWS_AS(load<point>(descriptor), std::runtime_error);
+
+    auto view = mapped_view<point>{path};
+    REQUIRE(view.size() == 10000);
+    REQUIRE(view[42].x == 42);
+
+    ::lseek(descriptor, 0, SEEK_SET);
+    REQUIRE_THROWS_AS(load<double>(descriptor), std::runtime_error);
+
+    ::ftruncate(descriptor, 1000);
+    ::lseek(descriptor, 0, SEEK_SET);
+    REQUIRE_THROWS_AS(loaded = load<point>(descriptor), std::runtime_error);
+    REQUIRE(loaded.size() == 10000);
+
+    char corrupt[vector_file_data_offset<point>()] = {};
+    auto huge = make_vector_file_header<point>(std::uint64_t{1} << 60);
+    std::memcpy(corrupt, &huge, sizeof(huge));
+    ::lseek(descriptor, 0, SEEK_SET);
+    ::write(descriptor, corrupt, sizeof(corrupt));
+    ::lseek(descriptor, 0, SEEK_SET);
+    REQUIRE_THROWS_AS(load<point>(descriptor), std::runtime_error);
+    ::close(descriptor);
+    std::remove(path);
+}
+
+TEST_CASE("append_from_fd commits whole elements and keeps partial bytes") {
+    int pipe_ends[2];
+    REQUIRE(::pipe(pipe_ends) == 0);
+    std::uint32_t values[4] = {1, 2, 3, 4};
+    auto bytes = reinterpret_cast<const char*>(values);
+
+    auto v = vector<std::uint32_t>{};
+    auto cursor = append_cursor{};
+    ::write(pipe_ends[1], bytes, 10);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 10);
+    REQUIRE(v.size() == 2);
+    REQUIRE(cursor.partial_bytes == 2);
+
+    ::write(pipe_ends[1], bytes + 10, 6);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 1, cursor) == 1);
+    REQUIRE(v.size() == 2);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 5);
+    REQUIRE(v.size() == 4);
+    REQUIRE(std::equal(v.begin(), v.end(), values));
+
+    ::fcntl(pipe_ends[0], F_SETFL, O_NONBLOCK);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 0);
+    REQUIRE(!cursor.eof);
+    ::write(pipe_ends[1], bytes, 2);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 2);
+    auto capacity = v.capacity();
+    REQUIRE_THROWS_AS(v.append_from_fd(-1, 4096, cursor), std::system_error);
+    REQUIRE(v.capacity() > capacity);
+    REQUIRE(cursor.partial_bytes == 2);
+    ::write(pipe_ends[1], bytes + 2, 2);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 2);
+    REQUIRE(v.size() == 5);
+    REQUIRE(v[4] == 1);
+
+    ::close(pipe_ends[1]);
+    REQUIRE(v.append_from_fd(pipe_ends[0], 64, cursor) == 0);
+    REQUIRE(cursor.eof);
+    ::close(pipe_ends[0]);
+
+    char path[] = "/tmp/append_from_fd_XXXXXX";
+    auto descriptor = ::mkstemp(path);
+    ::write(descriptor, bytes, sizeof(values));
+    auto from_file = vector<std::uint32_t>{};
+    auto file_cursor = append_cursor{};
+    from_file.append_from_fd(descriptor, 6, 4, file_cursor);
+    REQUIRE(from_file.size() == 1);
+    from_file.append_from_fd(descriptor, 64, 10, file_cursor);
+    REQUIRE(from_file.size() == 3);
+    REQUIRE(from_file[2] == 4);
+    REQUIRE(!file_cursor.eof);
+    REQUIRE(from_file.append_from_fd(descriptor, 64, 16, file_cursor) == 0);
+    REQUIRE(file_cursor.eof);
+    ::close(descriptor);
+    std::remove(path);
+}
+
+TEST_CASE("load_async fills a presized vector from file ranges") {
+    char path[] = "/tmp/load_async_XXXXXX";
+    auto descriptor = ::mkstemp(path);
+    auto written = vector<std::uint32_t>{};
+    for(auto i = std::uint32_t{0}; i < 300000; ++i)
+        written.push_back(i * 7);
+    ::write(descriptor, written.data(), written.size() * sizeof(std::uint32_t));
+
+    // The second half of the file first, then the first half.
+    auto half = written.size() / 2 * sizeof(std::uint32_t);
+    auto ranges = std::vector<file_range>{
+        {descriptor, static_cast<off_t>(half), half},
+        {descriptor, 0, half},
+    };
+    for(auto use_io_uring : {true, false}) {
+        auto options = bulk_load_options{};
+        options.chunk_bytes = 65536 + 12;
+        options.io_uring = use_io_uring;
+
+        auto loaded = vector<std::uint32_t>(written.size());
+        load_async(loaded, ranges, options).get();
+        REQUIRE(std::equal(loaded.begin(), loaded.begin() + 150000, written.begin() + 150000));
+        REQUIRE(std::equal(loaded.begin() + 150000, loaded.end(), written.begin()));
+
+        auto past_end = std::vector<file_range>{{descriptor, static_cast<off_t>(half), half + 4}};
+        auto too_long = vector<std::uint32_t>(written.size() / 2 + 1);
+        REQUIRE_THROWS_AS(load_async(too_long, past_end, options).get(), std::runtime_error);
+    }
+    auto wrong_size = vector<std::uint32_t>(10);
+    REQUIRE_THROWS_AS(load_async(wrong_size, ranges), std::length_error);
+    ::close(descriptor);
+    std::remove(path);
+}
+
+TEST_CASE("direct_io_vector buffers are whole aligned blocks") {
+    auto bytes = direct_io_vector<char>{};
+    bytes.push_back('a');
+    REQUIRE(reinterpret_cast<std::uintptr_t>(bytes.data()) % 4096 == 0);
+    REQUIRE(bytes.capacity() == 4096);
+    bytes.resize(4097);
+    REQUIRE(bytes.capacity() % 4096 == 0);
+
+    struct record { char text[12]; };
+    auto records = direct_io_vector<record>{};
+    auto padded = true;
+    for(auto i = 0; i < 2000; ++i) {
+        records.push_back({});
+        padded = padded && records.capacity() * sizeof(record) % 4096 == 0;
+    }
+    REQUIRE(padded);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(records.data()) % 4096 == 0);
+    records.shrink_to_fit();
+    REQUIRE(records.capacity() == 2048);
+    auto allocations = vector_stats_for<direct_io_vector<record>>().snapshot().allocations;
+    auto data = records.data();
+    records.pop_back();
+    records.shrink_to_fit();
+    REQUIRE(records.capacity() == 2048);
+    REQUIRE(records.data() == data);
+    REQUIRE(vector_stats_for<direct_io_vector<record>>().snapshot().allocations == allocations);
+}
+
+TEST_CASE("external_vector keeps a bounded window of pages in memory") {
+    auto v = external_vector<std::uint64_t>{4 * 4096, 4096};
+    REQUIRE(v.page_size() == 512);
+    REQUIRE(v.max_cached_pages() == 4);
+
+    for(auto i = std::uint64_t{0}; i < 100000; ++i)
+        v.push_back(i * 3);
+    REQUIRE(v.size() == 100000);
+    REQUIRE(v.cached_pages() == 4);
+
+    v.flush();
+    auto writes = v.page_writes();
+    auto sum = std::uint64_t{0};
+    for(auto value : v)
+        sum += value;
+    for(auto i = std::size_t{0}; i < v.size(); i += 100)
+        sum -= v[i];
+    REQUIRE(sum == 3 * (99999ull * 100000 / 2) - 3 * (99900ull * 1000 / 2));
+    REQUIRE(v.page_writes() == writes);
+
+    v[10] = 1;
+    v[99990] = 2;
+    REQUIRE(v[50000] == 150000);
+    REQUIRE(v[10] == 1);
+    REQUIRE(v.at(99990) == 2);
+    REQUIRE(v.cached_pages() <= v.max_cached_pages());
+
+    v.resize(10);
+    v.push_back(7);
+    REQUIRE(v.back() == 7);
+    v.clear();
+    REQUIRE(v.empty());
+}
+
+TEST_CASE("external_sort merges sorted runs back into the vector") {
+    auto v = external_vector<std::uint64_t>{8 * 4096, 4096};
+    auto state = std::uint64_t{12345};
+    auto sum = std::uint64_t{0};
+    for(auto i = 0; i < 200000; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        v.push_back(state >> 16);
+        sum += state >> 16;
+    }
+
+    external_sort(v, 64 * 1024, std::less<>{}, 4);
+
+    REQUIRE(v.size() == 200000);
+    REQUIRE(std::is_sorted(v.begin(), v.end()));
+    auto sorted_sum = std::uint64_t{0};
+    for(auto value : v)
+        sorted_sum += value;
+    REQUIRE(sorted_sum == sum);
+
+    // Fewer runs than the budget holds buffers for : a single merge pass.
+    external_sort(v, 1 << 20, std::greater<>{}, 4);
+    REQUIRE(std::is_sorted(v.begin(), v.end(), std::greater<>{}));
+    REQUIRE(v.front() >= v.back());
+
+    auto small = vector<int>{};
+    for(auto value : {5, 3, 9, 1, 7, 3})
+        small.push_back(value);
+    external_sort(small, 8, std::greater<>{}, 3);
+    REQUIRE(std::equal(small.begin(), small.end(), std::vector<int>{9, 7, 5, 3, 3, 1}.begin()));
+
+    auto throwing_compare = [](int x, int y) {
+        if(x == 7 || y == 7)
+            throw std::runtime_error{"compare"};
+        return x < y;
+    };
+    REQUIRE_THROWS_AS(external_sort(small, 8, throwing_compare, 3), std::runtime_error);
+    REQUIRE(std::equal(small.begin(), small.end(), std::vector<int>{9, 7, 5, 3, 3, 1}.begin()));
+}
+
+TEST_CASE("shm_vectors are read in place through another mapping") {
+    auto name = "/cpp_std_vector_tests_" + std::to_string(::getpid());
+    auto writer = shm_segment{name.c_str(), 1 << 20};
+    auto reader = shm_segment{name.c_str()};
+    shm_segment::remove(name.c_str());
+
+    auto& written = writer.construct_root<shm_vector<int>>(shm_allocator<int>{writer});
+    for(auto i = 0; i < 10000; ++i)
+        written.push_back(i);
+
+    auto read = reader.root<const shm_vector<int>>();
+    REQUIRE(read != nullptr);
+    REQUIRE(static_cast<const void*>(read) != &written);
+    REQUIRE(read->data() != written.data());
+    REQUIRE(read->size() == 10000);
+    REQUIRE(std::equal(read->begin(), read->end(), written.begin()));
+    REQUIRE(reader.used_bytes() == writer.used_bytes());
+
+    auto used = writer.used_bytes();
+    auto released = written.release();
+    written.get_allocator().deallocate(released.data, released.capacity);
+    REQUIRE(writer.used_bytes() < used);
+    REQUIRE(reader.root<shm_vector<int>>()->empty());
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include<algorithm>
+#include<initializer_list>
+#include<iterator>
+#include<memory>
+#include<stdexcept>
+#include<type_traits>
+
+// Vector whose object is a single pointer : size and capacity live in a
+// header at the start of the heap block, followed by the elements. Empty
+// vectors point to a shared static header, so they cost no allocation.
+// The allocator is default constructed on use and must be stateless.
+
+template<class Value, class Allocator = std::allocator<Value>>
+class thin_vector {
+	static_assert(
+		std::allocator_traits<Allocator>::is_always_equal::value,
+		"thin_vector : Allocator must be stateless");
+
+public:
+
+	// types
+
+	using value_type = Value;
+	using allocator_type = Allocator;
+	using pointer = Value*;
+	using const_pointer = const Value*;
+	using reference = value_type&;
+	using const_reference = const value_type&;
+	using size_type = typename std::allocator_traits<Allocator>::size_type;
+	using difference_type = typename std::allocator_traits<Allocator>::difference_type;
+	using iterator = Value*;
+	using const_iterator = const Value*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// construct/copy/destroy
+
+	thin_vector() noexcept
+		: header_{&empty_header}
+	{}
+
+	thin_vector(std::initializer_list<Value> values)
+		: thin_vector()
+	{
+		reserve(values.size());
+		for(auto& value : values)
+			push_back(value);
+	}
+
+	thin_vector(const thin_vector& from_vector)
+		: thin_vector()
+	{
+		reserve(from_vector.size());
+		for(auto& value : from_vector)
+			push_back(value);
+	}
+
+	thin_vector(thin_vector&& from_vector) noexcept
+		: header_{from_vector.header_}
+	{
+		from_vector.header_ = &empty_header;
+	}
+
+	~thin_vector() {
+		clear();
+		release(header_);
+	}
+
+	auto operator=(thin_vector from_vector) noexcept -> thin_vector& {
+		swap(from_vector);
+		return *this;
+	}
+
+	auto get_allocator() const noexcept -> allocator_type {
+		return Allocator();
+	}
+
+	// iterators
+
+	auto begin() noexcept -> iterator {
+		return data();
+	}
+
+	auto begin() const noexcept -> const_iterator {
+		return data();
+	}
+
+	auto end() noexcept -> iterator {
+		return data() + size();
+	}
+
+	auto end() const noexcept -> const_iterator {
+		return data() + size();
+	}
+
+	auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator{end()};
+	}
+
+	auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{end()};
+	}
+
+	auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator{begin()};
+	}
+
+	auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator{begin()};
+	}
+
+	auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+
+	auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	auto crbegin() const noexcept -> const_reverse_iterator {
+		return rbegin();
+	}
+
+	auto crend() const noexcept -> const_reverse_iterator {
+		return rend();
+	}
+
+	// capacity
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool {
+		return size() == 0;
+	}
+
+	auto size() const noexcept -> size_type {
+		return header_->size;
+	}
+
+	auto max_size() const noexcept -> size_type {
+		return (std::allocator_traits<header_allocator>::max_size(header_allocator()) - 1) * sizeof(header) / sizeof(Value);
+	}
+
+	auto capacity() const noexcept -> size_type {
+		return header_->capacity;
+	}
+
+	auto resize(size_type new_size) -> void {
+		if(new_size > capacity())
+			reserve(new_size);
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back();
+	}
+
+	auto resize(size_type new_size, const Value& to_copy) -> void {
+		if(new_size > capacity())
+			reserve(new_size);
+		while(size() > new_size)
+			pop_back();
+		while(size() < new_size)
+			emplace_back(to_copy);
+	}
+
+	auto reserve(size_type new_capacity) -> void {
+		if(new_capacity > max_size())
+			throw std::length_error{"thin_vector::reserve : new_capacity > max_size()"};
+
+		if(new_capacity > capacity())
+			relocate_to(new_capacity);
+	}
+
+	// Frees the block when empty, which gives the memory of a vector that
+	// was filled once and emptied back.
+	auto shrink_to_fit() -> void {
+		if(capacity() > size())
+			relocate_to(size());
+	}
+
+	// element access
+
+	auto operator[](size_type index) -> reference {
+		return data()[index];
+	}
+
+	auto operator[](size_type index) const -> const_reference {
+		return data()[index];
+	}
+
+	auto at(size_type index) -> reference {
+		if(index >= size())
+			throw std::out_of_range("thin_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	auto at(size_type index) const -> const_reference {
+		if(index >= size())
+			throw std::out_of_range("thin_vector::at : index >= size()");
+		return data()[index];
+	}
+
+	auto front() -> reference {
+		return data()[0];
+	}
+
+	auto front() const -> const_reference {
+		return data()[0];
+	}
+
+	auto back() -> reference {
+		return data()[size() - 1];
+	}
+
+	auto back() const -> const_reference {
+		return data()[size() - 1];
+	}
+
+	// data access
+
+	auto data() noexcept -> Value* {
+		return reinterpret_cast<Value*>(header_ + 1);
+	}
+
+	auto data() const noexcept -> const Value* {
+		return reinterpret_cast<const Value*>(header_ + 1);
+	}
+
+	// modifiers
+
+	template<class... Args>
+	auto emplace_back(Args&&... args) -> reference {
+		return *emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	auto push_back(const Value& to_push) -> void {
+		emplace_back(to_push);
+	}
+
+	auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	auto pop_back() -> void {
+		header_->size -= 1;
+		auto element_allocator = allocator();
+		std::allocator_traits<Allocator>::destroy(element_allocator, end());
+	}
+
+	template<class... Args>
+	auto emplace(const_iterator position, Args&&... args) -> iterator {
+		auto index = static_cast<size_type>(position - cbegin());
+		if(size() == capacity()) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			relocate_to(2 * capacity() + 1);
+			return emplace(begin() + index, std::move(to_emplace));
+		}
+		auto element_allocator = allocator();
+		if(index == size())
+			std::allocator_traits<Allocator>::construct(element_allocator, end(), std::forward<Args>(args)...);
+		else {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			std::allocator_traits<Allocator>::construct(element_allocator, end(), std::move(back()));
+			std::move_backward(begin() + index, end() - 1, end());
+			*(begin() + index) = std::move(to_emplace);
+		}
+		header_->size += 1;
+		return begin() + index;
+	}
+
+	auto insert(const_iterator position, const Value& to_insert) -> iterator {
+		return emplace(position, to_insert);
+	}
+
+	auto insert(const_iterator position, Value&& to_insert) -> iterator {
+		return emplace(position, std::move(to_insert));
+	}
+
+	auto erase(const_iterator position) -> iterator {
+		return erase(position, position + 1);
+	}
+
+	auto erase(const_iterator first, const_iterator last) -> iterator {
+		auto mutable_first = begin() + (first - cbegin());
+		auto new_end = std::move(begin() + (last - cbegin()), end(), mutable_first);
+		while(end() != new_end)
+			pop_back();
+		return mutable_first;
+	}
+
+	auto swap(thin_vector& to_swap) noexcept -> void {
+		std::swap(header_, to_swap.header_);
+	}
+
+	auto clear() noexcept -> void {
+		while(!empty())
+			pop_back();
+	}
+
+private:
+
+	struct alignas(alignof(Value) > alignof(size_type) ? alignof(Value) : alignof(size_type)) header {
+		size_type size;
+		size_type capacity;
+	};
+
+	using header_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<header>;
+
+	static inline header empty_header = {0, 0};
+
+	static auto allocator() noexcept -> Allocator {
+		return Allocator();
+	}
+
+	// Headers spanned by a block holding the header and capacity elements.
+	static auto block_size(size_type capacity) noexcept -> size_type {
+		return 1 + (capacity * sizeof(Value) + sizeof(header) - 1) / sizeof(header);
+	}
+
+	static auto release(header* block) noexcept -> void {
+		if(block == &empty_header)
+			return;
+		auto block_allocator = header_allocator();
+		std::allocator_traits<header_allocator>::deallocate(block_allocator, block, block_size(block->capacity));
+	}
+
+	auto relocate_to(size_type new_capacity) -> void {
+		auto previous = header_;
+		if(new_capacity == 0)
+			header_ = &empty_header;
+		else {
+			auto block_allocator = header_allocator();
+			header_ = std::allocator_traits<header_allocator>::allocate(block_allocator, block_size(new_capacity));
+			header_->size = previous->size;
+			header_->capacity = new_capacity;
+
+			auto element_allocator = allocator();
+			auto previous_data = reinterpret_cast<Value*>(previous + 1);
+			for(auto i = size_type{0}; i < size(); ++i) {
+				std::allocator_traits<Allocator>::construct(element_allocator, data() + i, std::move(previous_data[i]));
+				std::allocator_traits<Allocator>::destroy(element_allocator, previous_data + i);
+			}
+		}
+		release(previous);
+	}
+
+	header* header_;
+};
+
+template<class Value, class Allocator>
+void swap(thin_vector<Value, Allocator>& x, thin_vector<Value, Allocator>& y) noexcept {
+	x.swap(y);
+}
@@ -1,7 +1,115 @@
 #pragma once
 
+#include<algorithm>
+#include<cerrno>
+#include<cstddef>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<iterator>
 #include<memory>
 #include<stdexcept>
+#include<system_error>
+#include<type_traits>
+#include<utility>
+
+#if __has_include(<unistd.h>)
+#include<unistd.h>
+#endif
+
+#include "vector_stats.hpp"
+
+namespace vector_detail {
+
+	// Allocators with allocate_at_least(n), returning {ptr, count}, may hand
+	// out more than n elements, which the vector then uses as capacity.
+	template<class Allocator, class = void>
+	struct has_allocate_at_least : std::false_type {};
+
+	template<class Allocator>
+	struct has_allocate_at_least<Allocator, std::void_t<
+		decltype(std::declval<Allocator&>().allocate_at_least(std::size_t{}))>>
+		: std::true_type {};
+
+	// Allocators with allocation_size(n) tell how many elements
+	// allocate_at_least(n) would give, without allocating.
+	template<class Allocator, class = void>
+	struct has_allocation_size : std::false_type {};
+
+	template<class Allocator>
+	struct has_allocation_size<Allocator, std::void_t<
+		decltype(std::declval<const Allocator&>().allocation_size(std::size_t{}))>>
+		: std::true_type {};
+
+	// The address a pointer, possibly a fancy one, points to.
+	template<class Pointer>
+	auto to_address(const Pointer& p) noexcept {
+		if constexpr(std::is_pointer_v<Pointer>)
+			return p;
+		else
+			return vector_detail::to_address(p.operator->());
+	}
+
+	// Allocates at least n elements, sets n to the number allocated, and
+	// reports them to Probe. With VECTOR_SEAL_CHECKS, aborts instead when
+	// the container is sealed.
+	template<class Probe, class Allocator, class Size>
+	auto allocate(Allocator& allocator, Size& n, [[maybe_unused]] bool sealed)
+		-> typename std::allocator_traits<Allocator>::pointer
+	{
+#ifdef VECTOR_SEAL_CHECKS
+		if(sealed) {
+			std::fputs("vector : allocation in a sealed vector\n", stderr);
+			std::abort();
+		}
+#endif
+		auto allocated = typename std::allocator_traits<Allocator>::pointer{};
+		if constexpr(has_allocate_at_least<Allocator>::value) {
+			auto result = allocator.allocate_at_least(n);
+			allocated = result.ptr;
+			n = static_cast<Size>(result.count);
+		}
+		else
+			allocated = std::allocator_traits<Allocator>::allocate(allocator, n);
+		Probe::allocated(n);
+		return allocated;
+	}
+
+	template<class Probe, class Allocator, class Size>
+	auto deallocate(Allocator& allocator, typename std::allocator_traits<Allocator>::pointer p, Size n) -> void {
+		if(p == nullptr)
+			return;
+		std::allocator_traits<Allocator>::deallocate(allocator, p, n);
+		Probe::deallocated(n);
+	}
+
+	// The capacity a buffer for n elements would get, without allocating.
+	template<class Allocator, class Size>
+	auto allocation_size(const Allocator& allocator, Size n) -> Size {
+		if constexpr(has_allocation_size<Allocator>::value) {
+			if(n != 0)
+				return static_cast<Size>(allocator.allocation_size(n));
+		}
+		return n;
+	}
+
+	// Move-constructs count elements at to from the ones at from, destroying
+	// the sources as it goes.
+	template<class Allocator, class Value, class Size>
+	auto relocate(Allocator& allocator, Value* from, Size count, Value* to) -> void {
+		for(auto i = Size{0}; i < count; ++i) {
+			std::allocator_traits<Allocator>::construct(allocator, to + i, std::move(from[i]));
+			std::allocator_traits<Allocator>::destroy(allocator, from + i);
+		}
+	}
+}
+
+// Bytes of an incomplete element kept after end() between calls to
+// vector::append_from_fd, and whether the last call hit end of file.
+struct append_cursor {
+	std::size_t partial_bytes = 0;
+	bool eof = false;
+};
 
 template<class Value, class Allocator = std::allocator<Value>>
 class vector {
@@ -22,6 +130,13 @@ public:
 	using reverse_iterator = std::reverse_iterator<iterator>;
 	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+	// Storage handed out by release.
+	struct buffer {
+		pointer data;
+		size_type size;
+		size_type capacity;
+	};
+
 	// [vector.cons], construct/copy/destroy
 
 	vector() noexcept(noexcept(Allocator()))
@@ -69,14 +184,22 @@ public:
 		const Allocator& = Allocator()
 	);
 
-	vector(const vector& x);
+	vector(const vector& from_vector)
+		: vector(
+			std::allocator_traits<Allocator>::select_on_container_copy_construction(
+				from_vector.get_allocator()))
+	{
+		reserve(from_vector.size());
+		for(auto& value : from_vector)
+			push_back(value);
+	}
 
 	vector(vector&& from_vector) noexcept
 		: capacity_{from_vector.capacity()}
 		, size_{from_vector.size()}
 
-		, allocator{from_vector.get_allocator()}
-		, data_{from_vector.data()}
+		, allocator_{from_vector.get_allocator()}
+		, data_{from_vector.data_}
 	{
 		from_vector.capacity_ = 0;
 		from_vector.data_ = nullptr;
@@ -92,24 +215,50 @@ public:
 	~vector() {
 		for(auto it = begin(); it != end(); ++it)
 			std::allocator_traits<Allocator>::destroy(allocator_, it);
-		std::allocator_traits<Allocator>::deallocate(allocator_, data(), capacity());
+		probe::resized(size(), 0);
+		deallocate(data_, capacity());
 	}
 
-	auto operator=(const vector& x) -> vector&;
+	auto operator=(const vector& from_vector) -> vector& {
+		auto copy = vector{from_vector};
+		swap(copy);
+		return *this;
+	}
 
-	auto operator=(vector&& x) noexcept(
-		allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
-		allocator_traits<Allocator>::is_always_equal::value
-	)  -> vector&;
+	auto operator=(vector&& from_vector) noexcept(
+		std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+		std::allocator_traits<Allocator>::is_always_equal::value
+	)  -> vector& {
+		auto moved = vector{std::move(from_vector)};
+		swap(moved);
+		return *this;
+	}
 
-	auto operator=(std::initializer_list<Value>) -> vector&;
+	auto operator=(std::initializer_list<Value> values) -> vector& {
+		assign(values);
+		return *this;
+	}
 
-	template<class InputIterator>
-	auto assign(InputIterator first, InputIterator last) -> void;
+	template<
+		class InputIterator,
+		class = typename std::iterator_traits<InputIterator>::iterator_category>
+	auto assign(InputIterator first, InputIterator last) -> void {
+		clear();
+		using category = typename std::iterator_traits<InputIterator>::iterator_category;
+		if constexpr(std::is_base_of_v<std::forward_iterator_tag, category>)
+			reserve(static_cast<size_type>(std::distance(first, last)));
+		for(; first != last; ++first)
+			emplace_back(*first);
+	}
 
-	auto assign(size_type n, const Value& u) -> void;
+	auto assign(size_type n, const Value& u) -> void {
+		clear();
+		resize(n, u);
+	}
 
-	auto assign(std::initializer_list<Value>) -> void;
+	auto assign(std::initializer_list<Value> values) -> void {
+		assign(values.begin(), values.end());
+	}
 
 	auto get_allocator() const noexcept -> allocator_type {
 		return allocator_;
@@ -136,7 +285,7 @@ public:
 	}
 
 	auto rbegin() noexcept -> reverse_iterator {
-		return data() + size() - 1;
+		return reverse_iterator{end()};
 	}
 
 	auto rbegin() const noexcept -> const_reverse_iterator {
@@ -145,7 +294,7 @@ public:
 	}
 
 	auto rend() noexcept -> reverse_iterator {
-		return data() - 1;
+		return reverse_iterator{begin()};
 	}
 
 	auto rend() const noexcept -> const_reverse_iterator {
@@ -199,9 +348,10 @@ public:
 			for(auto i = size(); i < new_size; ++i)
 				std::allocator_traits<Allocator>::construct(allocator_, begin() + i);
 		}
+		set_size(new_size);
 	}
 
-	auto resize(size_type sz, const Value& to_copy) -> void {
+	auto resize(size_type new_size, const Value& to_copy) -> void {
 		if(new_size < size()) {
 			for(auto i = new_size; i < size(); ++i)
 				std::allocator_traits<Allocator>::destroy(allocator_, begin() + i);
@@ -212,27 +362,55 @@ public:
 			for(auto i = size(); i < new_size; ++i)
 				std::allocator_traits<Allocator>::construct(allocator_, begin() + i, to_copy);
 		}
+		set_size(new_size);
+	}
+
+	// Like resize, without initializing the new elements : they hold whatever
+	// the buffer held, and are meant to be written over, e.g. by read(2).
+	auto resize_for_overwrite(size_type new_size) -> void {
+		static_assert(std::is_trivially_copyable_v<Value>, "vector::resize_for_overwrite : Value must be trivially copyable");
+		if(new_size > capacity())
+			reserve(new_size);
+		set_size(new_size);
 	}
 
 	auto reserve(size_type new_capacity) -> void {
 		if(new_capacity > max_size())
 			throw std::length_error{"vector::reserve : new_capacity > max_size()"};
 			
-		if(new_capacity > capacity()) {
-			auto previous_data = data();
-			data_ = std::allocator_traits<Allocator>::allocate(allocator_, new_capacity);
+		if(new_capacity > capacity())
+			relocate(new_capacity);
+	}
 
-			auto previous_capacity = capacity();
-			capacity_ = new_capacity;
+	// Keeps the buffer when a new one would come back as large.
+	auto shrink_to_fit() -> void {
+		if(capacity() > vector_detail::allocation_size(allocator_, size()))
+			relocate(size());
+	}
 
-			for(auto i = size_type{0}; i < size(); ++i)
-				std::allocator_traits<Allocator>::construct(allocator_, begin() + i, std::move(*(previous_data + i)));
+	// Once sealed, a vector built with VECTOR_SEAL_CHECKS aborts instead of
+	// allocating. Sealing is a property of this object : it is not copied,
+	// moved or swapped along with the elements.
 
-			std::allocator_traits<Allocator>::deallocate(allocator_, previous_data, previous_capacity);
-		}
+	auto seal() noexcept -> void {
+#ifdef VECTOR_SEAL_CHECKS
+		sealed_ = true;
+#endif
+	}
+
+	auto unseal() noexcept -> void {
+#ifdef VECTOR_SEAL_CHECKS
+		sealed_ = false;
+#endif
 	}
 
-	auto shrink_to_fit() -> void;
+	auto sealed() const noexcept -> bool {
+#ifdef VECTOR_SEAL_CHECKS
+		return sealed_;
+#else
+		return false;
+#endif
+	}
 
 	// element access
 
@@ -277,7 +455,7 @@ public:
 	// [vector.data], data access
 
 	auto data() noexcept -> Value* {
-		return data_;
+		return vector_detail::to_address(data_);
 	}
 
 	auto data() const noexcept -> const Value* {
@@ -287,34 +465,83 @@ public:
 
 	// [vector.modifiers], modifiers
 
+	// When full, the new element is built before growing, as args may refer
+	// to an element of the vector.
 	template<class... Args>
-	auto emplace_back(Args&&... args) -> reference;
+	auto emplace_back(Args&&... args) -> reference {
+		if(size() == capacity()) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			reserve(2 * capacity() + 1);
+			std::allocator_traits<Allocator>::construct(allocator_, end(), std::move(to_emplace));
+		}
+		else
+			std::allocator_traits<Allocator>::construct(allocator_, end(), std::forward<Args>(args)...);
+		set_size(size() + 1);
+		return back();
+	}
 
 	auto push_back(const Value& to_push) -> void {
-		if(size() + 1 >= capacity())
-			reserve(2 * capacity() + 1);
-		std::allocator_traits<Allocator>::construct(allocator_, end(), to_push);
-		size += 1;
+		emplace_back(to_push);
 	}
 
-	auto push_back(Value&& x) -> void {
-		if(size() + 1 >= capacity())
-			reserve(2 * capacity() + 1);
-		std::allocator_traits<Allocator>::construct(allocator_, end(), std::move(to_push));
-		size += 1;
+	auto push_back(Value&& to_push) -> void {
+		emplace_back(std::move(to_push));
+	}
+
+	// Appends only within capacity() : never allocates, and returns false
+	// when the vector is full.
+	template<class... Args>
+	auto try_emplace_back(Args&&... args)
+	noexcept(std::is_nothrow_constructible_v<Value, Args...>) -> bool {
+		if(size() == capacity())
+			return false;
+		std::allocator_traits<Allocator>::construct(allocator_, end(), std::forward<Args>(args)...);
+		set_size(size() + 1);
+		return true;
+	}
+
+	auto try_push_back(const Value& to_push)
+	noexcept(std::is_nothrow_copy_constructible_v<Value>) -> bool {
+		return try_emplace_back(to_push);
+	}
+
+	auto try_push_back(Value&& to_push)
+	noexcept(std::is_nothrow_move_constructible_v<Value>) -> bool {
+		return try_emplace_back(std::move(to_push));
 	}
 
 	auto pop_back() -> void {
-		size -= 1;
+		set_size(size() - 1);
 		std::allocator_traits<Allocator>::destroy(allocator_, end());
 	}
 
 	template<class... Args>
-	auto emplace(const_iterator position, Args&&... args) -> iterator;
+	auto emplace(const_iterator position, Args&&... args) -> iterator {
+		auto index = static_cast<size_type>(position - cbegin());
+		if(size() + 1 > capacity()) {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			reserve(2 * capacity() + 1);
+			return emplace(begin() + index, std::move(to_emplace));
+		}
+		if(index == size())
+			std::allocator_traits<Allocator>::construct(allocator_, end(), std::forward<Args>(args)...);
+		else {
+			auto to_emplace = Value(std::forward<Args>(args)...);
+			std::allocator_traits<Allocator>::construct(allocator_, end(), std::move(back()));
+			std::move_backward(begin() + index, end() - 1, end());
+			*(begin() + index) = std::move(to_emplace);
+		}
+		set_size(size() + 1);
+		return begin() + index;
+	}
 
-	auto insert(const_iterator position, const Value& x) -> iterator;
+	auto insert(const_iterator position, const Value& to_insert) -> iterator {
+		return emplace(position, to_insert);
+	}
 
-	auto insert(const_iterator position, Value&& x) -> iterator;
+	auto insert(const_iterator position, Value&& to_insert) -> iterator {
+		return emplace(position, std::move(to_insert));
+	}
 
 	auto insert(const_iterator position, size_type n, const Value& x) -> iterator;
 
@@ -327,29 +554,169 @@ public:
 
 	auto insert(const_iterator position, std::initializer_list<Value> il) -> iterator;
 
-	auto erase(const_iterator position) -> iterator;
+	auto erase(const_iterator position) -> iterator {
+		return erase(position, position + 1);
+	}
 
-	auto erase(const_iterator first, const_iterator last) -> iterator;
+	auto erase(const_iterator first, const_iterator last) -> iterator {
+		auto mutable_first = begin() + (first - cbegin());
+		auto mutable_last = begin() + (last - cbegin());
+		auto new_end = std::move(mutable_last, end(), mutable_first);
+		for(auto it = new_end; it != end(); ++it)
+			std::allocator_traits<Allocator>::destroy(allocator_, it);
+		auto new_size = static_cast<size_type>(new_end - begin());
+		set_size(new_size);
+		return mutable_first;
+	}
 
 	auto swap(vector& to_swap)
 	noexcept(
-		allocator_traits<Allocator>::propagate_on_container_swap::value ||
-		allocator_traits<Allocator>::is_always_equal::value
+		std::allocator_traits<Allocator>::propagate_on_container_swap::value ||
+		std::allocator_traits<Allocator>::is_always_equal::value
 	) -> void {
 		std::swap(capacity_, to_swap.capacity_);
 		std::swap(size_, to_swap.size_);
 		std::swap(allocator_, to_swap.allocator_);
+		std::swap(data_, to_swap.data_);
+	}
+
+	auto clear() noexcept -> void {
+		for(auto it = begin(); it != end(); ++it)
+			std::allocator_traits<Allocator>::destroy(allocator_, it);
+		set_size(0);
 	}
 
-	auto clear() noexcept -> void;
+	// Takes ownership of a buffer of with_capacity elements allocated by
+	// with_allocator, or an equal allocator, whose first with_size elements
+	// are constructed. Nothing is copied.
+	static auto adopt(
+		pointer with_data,
+		size_type with_size,
+		size_type with_capacity,
+		const Allocator& with_allocator = Allocator()
+	) -> vector {
+		auto adopted = vector(with_allocator);
+		if(with_data != nullptr)
+			probe::allocated(with_capacity);
+		adopted.data_ = with_data;
+		adopted.capacity_ = with_capacity;
+		adopted.set_size(with_size);
+		return adopted;
+	}
+
+	// Gives up the buffer and leaves the vector empty. The caller then owns
+	// the size constructed elements, and deallocates the capacity with
+	// get_allocator().
+	auto release() noexcept -> buffer {
+		auto released = buffer{data_, size_, capacity_};
+		if(data_ != nullptr)
+			probe::deallocated(capacity_);
+		set_size(0);
+		data_ = nullptr;
+		capacity_ = 0;
+		return released;
+	}
+
+#if __has_include(<unistd.h>)
+	// Reads up to max_bytes from descriptor straight into the storage after
+	// end(), and appends the whole elements read. The bytes of an incomplete
+	// last element stay after end(), counted by cursor, and are completed by
+	// the next call with the same cursor; any other modifier drops them.
+	// Returns the bytes read, and 0 both at end of file and when a
+	// non-blocking descriptor has nothing to read yet : cursor.eof tells them
+	// apart, set only by end of file. Throws std::system_error when read
+	// fails, keeping the elements and the partial bytes.
+	auto append_from_fd(int descriptor, std::size_t max_bytes, append_cursor& cursor) -> std::size_t {
+		return append_read(max_bytes, cursor, [&](void* to, std::size_t bytes) {
+			return ::read(descriptor, to, bytes);
+		});
+	}
+
+	// Same, with pread from offset, which leaves the file offset alone.
+	auto append_from_fd(int descriptor, std::size_t max_bytes, off_t offset, append_cursor& cursor) -> std::size_t {
+		return append_read(max_bytes, cursor, [&](void* to, std::size_t bytes) {
+			return ::pread(descriptor, to, bytes, offset);
+		});
+	}
+#endif
 
 private:
 
-	unsigned capacity_;
-	unsigned size_;
+	using probe = vector_probe<vector>;
+
+	auto set_size(size_type new_size) noexcept -> void {
+		probe::resized(size(), new_size);
+		size_ = new_size;
+	}
+
+	template<class Read>
+	auto append_read(std::size_t max_bytes, append_cursor& cursor, Read read) -> std::size_t {
+		static_assert(std::is_trivially_copyable_v<Value>, "vector::append_from_fd : Value must be trivially copyable");
+		auto partial = cursor.partial_bytes;
+		auto needed = size() + (partial + max_bytes + sizeof(Value) - 1) / sizeof(Value);
+		if(needed > capacity()) {
+			unsigned char kept[sizeof(Value)];
+			if(partial != 0)
+				std::memcpy(kept, data() + size_, partial);
+			reserve(std::max<size_type>(needed, 2 * capacity() + 1));
+			if(partial != 0)
+				std::memcpy(data() + size_, kept, partial);
+		}
+
+		auto tail = reinterpret_cast<unsigned char*>(data() + size_) + partial;
+		auto got = read(tail, max_bytes);
+		while(got < 0 && errno == EINTR)
+			got = read(tail, max_bytes);
+		if(got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			cursor.eof = false;
+			return 0;
+		}
+		// The cursor is left alone, and the partial bytes were carried over by
+		// reserve, so a failed call can be retried.
+		if(got < 0)
+			throw std::system_error{errno, std::generic_category(), "vector::append_from_fd"};
+
+		auto bytes = partial + static_cast<std::size_t>(got);
+		set_size(size() + bytes / sizeof(Value));
+		cursor.partial_bytes = bytes % sizeof(Value);
+		cursor.eof = got == 0 && max_bytes != 0;
+		return static_cast<std::size_t>(got);
+	}
+
+	// Allocates at least n elements, and sets n to the number allocated.
+	auto allocate(size_type& n) -> pointer {
+		return vector_detail::allocate<probe>(allocator_, n, sealed());
+	}
+
+	// Moves the elements to a new buffer of at least new_capacity >= size(),
+	// or to no buffer at all when new_capacity is 0.
+	auto relocate(size_type new_capacity) -> void {
+		auto previous_data = data_;
+		data_ = new_capacity == 0 ? pointer{} : allocate(new_capacity);
+
+		auto previous_capacity = capacity();
+		capacity_ = new_capacity;
+
+		vector_detail::relocate(allocator_, vector_detail::to_address(previous_data), size(), data());
+
+		if(previous_data != nullptr)
+			probe::reallocated(size(), size() * sizeof(Value));
+		deallocate(previous_data, previous_capacity);
+	}
+
+	auto deallocate(pointer p, size_type n) -> void {
+		vector_detail::deallocate<probe>(allocator_, p, n);
+	}
+
+	size_type capacity_;
+	size_type size_;
 
 	Allocator allocator_;
-	Value* data_;
+	pointer data_;
+
+#ifdef VECTOR_SEAL_CHECKS
+	bool sealed_ = false;
+#endif
 };
 
 // template<class InputIterator, class Allocator = allocator<iter-value-type<InputIterator>>>
@@ -360,4 +727,6 @@ private:
 
 template<class Value, class Allocator>
 void swap(vector<Value, Allocator>& x, vector<Value, Allocator>& y)
-noexcept(noexcept(x.swap(y)));
+noexcept(noexcept(x.swap(y))) {
+	x.swap(y);
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include<algorithm>
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<new>
+#include<stdexcept>
+#include<vector>
+
+#include "vector.hpp"
+
+// Bump allocator for many short-lived vectors : allocations are carved from
+// large slabs, deallocation only gives back the most recent block, and
+// release() frees every slab at once. Growing a vector copies it into fresh
+// arena space, so an arena suits workloads that build many small vectors and
+// drop them all together. Long-lived vectors can be packed back into a single
+// slab with compact().
+
+class vector_arena {
+public:
+
+	static constexpr std::size_t default_slab_size = 64 * 1024;
+
+	explicit
+	vector_arena(std::size_t with_slab_size = default_slab_size) noexcept
+		: slab_size_{with_slab_size}
+		, top_{nullptr}
+		, limit_{nullptr}
+	{}
+
+	vector_arena(const vector_arena&) = delete;
+
+	auto operator=(const vector_arena&) -> vector_arena& = delete;
+
+	~vector_arena() {
+		release();
+	}
+
+	auto allocate(std::size_t bytes, std::size_t alignment) -> void* {
+		auto aligned = align(top_, alignment);
+		if(aligned == nullptr || aligned > limit_ || bytes > static_cast<std::size_t>(limit_ - aligned)) {
+			add_slab(std::max(slab_size_, bytes + alignment));
+			aligned = align(top_, alignment);
+		}
+		top_ = aligned + bytes;
+		return aligned;
+	}
+
+	// Only the most recent block is reclaimed, the others wait for release().
+	auto deallocate(void* p, std::size_t bytes) noexcept -> void {
+		if(static_cast<std::byte*>(p) + bytes == top_)
+			top_ = static_cast<std::byte*>(p);
+	}
+
+	// Frees every slab. Vectors allocated from the arena must not be used
+	// afterwards, except to be destroyed.
+	auto release() noexcept -> void {
+		for(auto& slab : slabs_)
+			::operator delete(slab.data, slab.size);
+		slabs_.clear();
+		top_ = nullptr;
+		limit_ = nullptr;
+	}
+
+	// Moves the elements of the given vectors into one new slab sized to fit
+	// them exactly, shrinking each capacity() to size(), then frees the
+	// previous slabs. Every live vector of the arena must be passed, the
+	// ones left out would point into freed memory.
+	template<class... Vectors>
+	auto compact(Vectors&... vectors) -> void {
+		if(!((vectors.get_allocator().arena() == this) && ...))
+			throw std::invalid_argument{"vector_arena::compact : vector from another arena"};
+
+		auto bytes = std::size_t{0};
+		auto alignment = std::size_t{__STDCPP_DEFAULT_NEW_ALIGNMENT__};
+		auto add = [&](std::size_t size, std::size_t value_size, std::size_t value_alignment) {
+			if(size == 0)
+				return;
+			bytes = (bytes + value_alignment - 1) / value_alignment * value_alignment + size * value_size;
+			alignment = std::max(alignment, value_alignment);
+		};
+		(add(vectors.size(), sizeof(typename Vectors::value_type), alignof(typename Vectors::value_type)), ...);
+
+		auto previous_slabs = std::move(slabs_);
+		slabs_.clear();
+		top_ = nullptr;
+		limit_ = nullptr;
+		try {
+			if(bytes != 0)
+				add_slab(bytes + alignment - __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+			(relocate(vectors), ...);
+		}
+		catch(...) {
+			slabs_.insert(slabs_.end(), previous_slabs.begin(), previous_slabs.end());
+			throw;
+		}
+		for(auto& slab : previous_slabs)
+			::operator delete(slab.data, slab.size);
+	}
+
+	auto slab_count() const noexcept -> std::size_t {
+		return slabs_.size();
+	}
+
+	// Bytes held in slabs, whether handed out or not.
+	auto reserved_bytes() const noexcept -> std::size_t {
+		auto bytes = std::size_t{0};
+		for(auto& slab : slabs_)
+			bytes += slab.size;
+		return bytes;
+	}
+
+private:
+
+	struct slab {
+		std::byte* data;
+		std::size_t size;
+	};
+
+	static auto align(std::byte* p, std::size_t alignment) noexcept -> std::byte* {
+		if(p == nullptr)
+			return nullptr;
+		auto address = reinterpret_cast<std::uintptr_t>(p);
+		auto aligned = (address + alignment - 1) & ~(alignment - 1);
+		return p + (aligned - address);
+	}
+
+	auto add_slab(std::size_t size) -> void {
+		slabs_.reserve(slabs_.size() + 1);
+		auto data = static_cast<std::byte*>(::operator new(size));
+		slabs_.push_back({data, size});
+		top_ = data;
+		limit_ = data + size;
+	}
+
+	template<class Vector>
+	static auto relocate(Vector& vector) -> void {
+		if(vector.capacity() == 0)
+			return;
+		auto relocated = Vector(vector.get_allocator());
+		relocated.reserve(vector.size());
+		for(auto& value : vector)
+			relocated.push_back(std::move(value));
+		vector.swap(relocated);
+	}
+
+	std::size_t slab_size_;
+	std::vector<slab> slabs_;
+	std::byte* top_;
+	std::byte* limit_;
+};
+
+template<class Value>
+class arena_allocator {
+public:
+
+	using value_type = Value;
+
+	arena_allocator(vector_arena& with_arena) noexcept
+		: arena_{&with_arena}
+	{}
+
+	template<class Other>
+	arena_allocator(const arena_allocator<Other>& from_allocator) noexcept
+		: arena_{from_allocator.arena()}
+	{}
+
+	auto allocate(std::size_t n) -> Value* {
+		return static_cast<Value*>(arena_->allocate(n * sizeof(Value), alignof(Value)));
+	}
+
+	auto deallocate(Value* p, std::size_t n) noexcept -> void {
+		arena_->deallocate(p, n * sizeof(Value));
+	}
+
+	auto arena() const noexcept -> vector_arena* {
+		return arena_;
+	}
+
+private:
+
+	vector_arena* arena_;
+};
+
+template<class Value, class Other>
+auto operator==(const arena_allocator<Value>& x, const arena_allocator<Other>& y) noexcept -> bool {
+	return x.arena() == y.arena();
+}
+
+template<class Value, class Other>
+auto operator!=(const arena_allocator<Value>& x, const arena_allocator<Other>& y) noexcept -> bool {
+	return !(x == y);
+}
+
+template<class Value>
+using arena_vector = vector<Value, arena_allocator<Value>>;
+
+// Compacts the vectors, which must all come from the same arena.
+template<class Vector, class... Vectors>
+auto compact(Vector& vector, Vectors&... vectors) -> void {
+	vector.get_allocator().arena()->compact(vector, vectors...);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<stdexcept>
+#include<type_traits>
+
+// On-disk layout of a vector of trivially copyable values : a header, then
+// the elements as raw bytes from vector_file_data_offset<Value>() on, so a
+// mapping of the file can be used in place. The header records what the
+// bytes depend on, and files written with another element size, alignment
+// or byte order are refused instead of being misread.
+
+struct vector_file_header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t byte_order;
+	std::uint64_t element_size;
+	std::uint64_t element_alignment;
+	std::uint64_t count;
+};
+
+namespace vector_file_detail {
+
+	constexpr char magic[8] = {'v', 'e', 'c', 't', 'o', 'r', '\0', '\0'};
+
+	constexpr std::uint32_t version = 1;
+
+	// Reads back as 0x04030201 on a machine of the other byte order.
+	constexpr std::uint32_t byte_order = 0x01020304;
+}
+
+// Elements start on a cache line, or on their own alignment if larger.
+template<class Value>
+constexpr auto vector_file_data_offset() noexcept -> std::size_t {
+	return alignof(Value) > 64 ? alignof(Value) : 64;
+}
+
+template<class Value>
+auto make_vector_file_header(std::uint64_t count) noexcept -> vector_file_header {
+	static_assert(std::is_trivially_copyable_v<Value>, "vector_file : Value must be trivially copyable");
+	auto header = vector_file_header{};
+	std::memcpy(header.magic, vector_file_detail::magic, sizeof(header.magic));
+	header.version = vector_file_detail::version;
+	header.byte_order = vector_file_detail::byte_order;
+	header.element_size = sizeof(Value);
+	header.element_alignment = alignof(Value);
+	header.count = count;
+	return header;
+}
+
+// Throws std::runtime_error when the header does not describe Values.
+template<class Value>
+auto check_vector_file_header(const vector_file_header& header) -> void {
+	if(std::memcmp(header.magic, vector_file_detail::magic, sizeof(header.magic)) != 0)
+		throw std::runtime_error{"vector_file : not a vector file"};
+	if(header.version != vector_file_detail::version)
+		throw std::runtime_error{"vector_file : unsupported version"};
+	if(header.byte_order != vector_file_detail::byte_order)
+		throw std::runtime_error{"vector_file : written with another byte order"};
+	if(header.element_size != sizeof(Value) || header.element_alignment != alignof(Value))
+		throw std::runtime_error{"vector_file : written with another element type"};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include<cerrno>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<type_traits>
+
+#include<sys/stat.h>
+#include<sys/uio.h>
+#include<unistd.h>
+
+#include "vector.hpp"
+#include "vector_file.hpp"
+
+// Binary save and load of vectors of trivially copyable values, in the
+// vector_file layout : the header and the elements go out in one writev, and
+// come back with one read into the vector's storage, which is not
+// initialized first. A saved file can also be opened with mapped_view.
+
+namespace vector_io_detail {
+
+	[[noreturn]]
+	inline auto throw_errno(const char* call) -> void {
+		throw std::system_error{errno, std::generic_category(), std::string{"vector_io : "} + call};
+	}
+
+	// Writes every byte of the buffers, going on after partial writes.
+	inline auto write_all(int descriptor, iovec* buffers, int count) -> void {
+		while(count > 0) {
+			auto written = ::writev(descriptor, buffers, count);
+			if(written < 0) {
+				if(errno == EINTR)
+					continue;
+				throw_errno("writev");
+			}
+			auto remaining = static_cast<std::size_t>(written);
+			for(; count > 0 && remaining >= buffers->iov_len; ++buffers, --count)
+				remaining -= buffers->iov_len;
+			if(count > 0) {
+				buffers->iov_base = static_cast<char*>(buffers->iov_base) + remaining;
+				buffers->iov_len -= remaining;
+			}
+		}
+	}
+
+	// Reads exactly bytes, and throws std::runtime_error if the file ends first.
+	inline auto read_all(int descriptor, void* to, std::size_t bytes) -> void {
+		auto position = static_cast<char*>(to);
+		while(bytes > 0) {
+			auto got = ::read(descriptor, position, bytes);
+			if(got < 0) {
+				if(errno == EINTR)
+					continue;
+				throw_errno("read");
+			}
+			if(got == 0)
+				throw std::runtime_error{"vector_io : file truncated"};
+			position += got;
+			bytes -= static_cast<std::size_t>(got);
+		}
+	}
+
+	// Bytes left after the current offset of a regular file, or -1 for other
+	// descriptors, whose size is not known ahead.
+	inline auto remaining_bytes(int descriptor) -> off_t {
+		struct stat status;
+		if(::fstat(descriptor, &status) != 0)
+			throw_errno("fstat");
+		if(!S_ISREG(status.st_mode))
+			return -1;
+		auto offset = ::lseek(descriptor, 0, SEEK_CUR);
+		if(offset < 0)
+			throw_errno("lseek");
+		return status.st_size > offset ? status.st_size - offset : 0;
+	}
+}
+
+// Writes the vector at the current offset of descriptor.
+template<class Value, class Allocator>
+auto save(const vector<Value, Allocator>& values, int descriptor) -> void {
+	char header[vector_file_data_offset<Value>()] = {};
+	auto file_header = make_vector_file_header<Value>(values.size());
+	std::memcpy(header, &file_header, sizeof(file_header));
+
+	iovec buffers[2] = {
+		{header, sizeof(header)},
+		{const_cast<Value*>(values.data()), values.size() * sizeof(Value)},
+	};
+	vector_io_detail::write_all(descriptor, buffers, 2);
+}
+
+// Reads a vector saved by save from the current offset of descriptor. The
+// count in the header is checked against the size of a regular file before
+// anything is allocated. On failure, the partly read vector is dropped, so
+// `v = load<Value>(descriptor)` leaves v as it was.
+template<class Value, class Allocator = std::allocator<Value>>
+auto load(int descriptor, const Allocator& with_allocator = Allocator()) -> vector<Value, Allocator> {
+	char header[vector_file_data_offset<Value>()];
+	vector_io_detail::read_all(descriptor, header, sizeof(header));
+	auto file_header = vector_file_header{};
+	std::memcpy(&file_header, header, sizeof(file_header));
+	check_vector_file_header<Value>(file_header);
+
+	auto remaining = vector_io_detail::remaining_bytes(descriptor);
+	if(remaining >= 0 && file_header.count > static_cast<std::uint64_t>(remaining) / sizeof(Value))
+		throw std::runtime_error{"vector_io : count larger than the file"};
+
+	auto loaded = vector<Value, Allocator>(with_allocator);
+	if(file_header.count > loaded.max_size())
+		throw std::length_error{"vector_io : count > max_size()"};
+	loaded.resize_for_overwrite(static_cast<typename vector<Value, Allocator>::size_type>(file_header.count));
+	vector_io_detail::read_all(descriptor, loaded.data(), loaded.size() * sizeof(Value));
+	return loaded;
+}
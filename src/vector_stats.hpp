@@ -0,0 +1,166 @@
+#pragma once
+
+#include<cstddef>
+
+#ifdef VECTOR_INSTRUMENTATION
+#include<atomic>
+#include<typeinfo>
+#include<vector>
+#endif
+
+// Allocation and growth counters, one set per vector instantiation.
+// Compiled in only when VECTOR_INSTRUMENTATION is defined, which must be
+// consistent across every translation unit of a program.
+
+struct vector_stats_snapshot {
+	const char* name;
+
+	std::size_t allocations;
+	std::size_t deallocations;
+	std::size_t reallocations;
+	std::size_t relocated_elements;
+	std::size_t relocated_bytes;
+	std::size_t live_capacity;
+	std::size_t live_size;
+	// Largest live_capacity so far, buffers of every vector counted.
+	std::size_t peak_capacity;
+
+	auto slack() const noexcept -> std::size_t {
+		return live_capacity - live_size;
+	}
+};
+
+#ifdef VECTOR_INSTRUMENTATION
+
+class vector_stats {
+public:
+
+	explicit
+	vector_stats(const char* with_name) noexcept
+		: name_{with_name}
+	{}
+
+	auto snapshot() const noexcept -> vector_stats_snapshot {
+		return {
+			name_,
+			allocations_.load(std::memory_order_relaxed),
+			deallocations_.load(std::memory_order_relaxed),
+			reallocations_.load(std::memory_order_relaxed),
+			relocated_elements_.load(std::memory_order_relaxed),
+			relocated_bytes_.load(std::memory_order_relaxed),
+			live_capacity_.load(std::memory_order_relaxed),
+			live_size_.load(std::memory_order_relaxed),
+			peak_capacity_.load(std::memory_order_relaxed),
+		};
+	}
+
+	auto allocated(std::size_t capacity) noexcept -> void {
+		allocations_.fetch_add(1, std::memory_order_relaxed);
+		auto live = live_capacity_.fetch_add(capacity, std::memory_order_relaxed) + capacity;
+		auto peak = peak_capacity_.load(std::memory_order_relaxed);
+		while(live > peak && !peak_capacity_.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			;
+	}
+
+	auto deallocated(std::size_t capacity) noexcept -> void {
+		deallocations_.fetch_add(1, std::memory_order_relaxed);
+		live_capacity_.fetch_sub(capacity, std::memory_order_relaxed);
+	}
+
+	auto reallocated(std::size_t elements, std::size_t bytes) noexcept -> void {
+		reallocations_.fetch_add(1, std::memory_order_relaxed);
+		relocated_elements_.fetch_add(elements, std::memory_order_relaxed);
+		relocated_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+	}
+
+	auto resized(std::size_t previous_size, std::size_t new_size) noexcept -> void {
+		live_size_.fetch_add(new_size - previous_size, std::memory_order_relaxed);
+	}
+
+private:
+
+	const char* name_;
+
+	std::atomic<std::size_t> allocations_{0};
+	std::atomic<std::size_t> deallocations_{0};
+	std::atomic<std::size_t> reallocations_{0};
+	std::atomic<std::size_t> relocated_elements_{0};
+	std::atomic<std::size_t> relocated_bytes_{0};
+	std::atomic<std::size_t> live_capacity_{0};
+	std::atomic<std::size_t> live_size_{0};
+	std::atomic<std::size_t> peak_capacity_{0};
+};
+
+namespace vector_stats_detail {
+
+	// Registered counters form a list that is only ever pushed to, with
+	// static nodes, so that registering from the noexcept probes of a
+	// vector never allocates nor locks.
+	struct node {
+		vector_stats stats;
+		const node* next;
+	};
+
+	inline auto registry() noexcept -> std::atomic<const node*>& {
+		static auto head = std::atomic<const node*>{nullptr};
+		return head;
+	}
+
+	template<class Vector>
+	auto make_registered() noexcept -> vector_stats* {
+		static auto registered = node{vector_stats{typeid(Vector).name()}, nullptr};
+		auto& head = registry();
+		registered.next = head.load(std::memory_order_relaxed);
+		while(!head.compare_exchange_weak(registered.next, &registered, std::memory_order_release, std::memory_order_relaxed))
+			;
+		return &registered.stats;
+	}
+}
+
+template<class Vector>
+auto vector_stats_for() noexcept -> vector_stats& {
+	static auto stats = vector_stats_detail::make_registered<Vector>();
+	return *stats;
+}
+
+// Counters of every instantiation used so far; safe to call from any thread.
+inline auto vector_stats_snapshots() -> std::vector<vector_stats_snapshot> {
+	auto snapshots = std::vector<vector_stats_snapshot>{};
+	for(auto registered = vector_stats_detail::registry().load(std::memory_order_acquire); registered != nullptr; registered = registered->next)
+		snapshots.push_back(registered->stats.snapshot());
+	return snapshots;
+}
+
+template<class Vector>
+struct vector_probe {
+	static auto allocated(std::size_t capacity) noexcept -> void {
+		vector_stats_for<Vector>().allocated(capacity);
+	}
+
+	static auto deallocated(std::size_t capacity) noexcept -> void {
+		vector_stats_for<Vector>().deallocated(capacity);
+	}
+
+	static auto reallocated(std::size_t elements, std::size_t bytes) noexcept -> void {
+		vector_stats_for<Vector>().reallocated(elements, bytes);
+	}
+
+	static auto resized(std::size_t previous_size, std::size_t new_size) noexcept -> void {
+		vector_stats_for<Vector>().resized(previous_size, new_size);
+	}
+};
+
+#else
+
+template<class Vector>
+struct vector_probe {
+	static auto allocated(std::size_t) noexcept -> void {}
+
+	static auto deallocated(std::size_t) noexcept -> void {}
+
+	static auto reallocated(std::size_t, std::size_t) noexcept -> void {}
+
+	static auto resized(std::size_t, std::size_t) noexcept -> void {}
+};
+
+#endif